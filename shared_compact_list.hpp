@@ -0,0 +1,593 @@
+/*
+ *  Copyright (c) 2011-2014 Bonelli Nicola <nicola.bonelli@cnit.it>
+ *                          Loris Gazzarrini <loris.gazzarrini@for.iet.unipi.it>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef __SHARED_COMPACT_LIST_HPP__
+#define __SHARED_COMPACT_LIST_HPP__
+
+#include <shared_list.hpp>
+
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+
+namespace more {
+
+    ///////////////////// shared_compact_list
+    //
+    // A shared_list for small trivially copyable T, with its nodes in an
+    // array of fixed capacity allocated up front: nodes link each other
+    // through 32-bit indices, so that a node takes 8 bytes besides the
+    // value (e.g. 12 bytes for an int against 32) and iterations walk a
+    // dense array. Retired slots carry no stamp of their own: they are
+    // stamped by batches of scan_threshold, a batch taking the stamp of
+    // its latest slot, so that the stamps cost a fraction of a byte per
+    // slot and a slot may wait up to a batch longer than its grace period.
+    //
+    // Slots are only reused after the grace period, and the array is never
+    // freed while the list lives: a reader can read a stale value, never a
+    // dangling pointer. Only the ordered policies are supported. The list
+    // keeps its own retirement queue, not the garbage of shared_list:
+    // reclaimer, disposer, watermarks, synchronize() and defer() are not
+    // available, and expired slots are taken back by the writer only.
+    //
+
+    template <typename T, typename Time = TimeStampCounter, typename Alloc = std::allocator<T> >
+    struct shared_compact_list
+    {
+        static_assert(std::is_trivially_copyable<T>::value, "shared_compact_list: T must be trivially copyable");
+        static_assert(Time::ordered, "shared_compact_list: the reclamation policy must be ordered");
+
+    public:
+
+        typedef T                                   value_type;
+        typedef Alloc                               allocator_type;
+        typedef std::size_t                         size_type;
+        typedef std::ptrdiff_t                      difference_type;
+
+        typedef value_type &                        reference;
+        typedef const value_type &                  const_reference;
+        typedef value_type *                        pointer;
+        typedef const value_type *                  const_pointer;
+
+    private:
+
+        typedef uint32_t index;
+
+        static constexpr index npos = std::numeric_limits<index>::max();
+
+        struct node
+        {
+            std::atomic<index>  next;
+            index               prev;       /* free and retired nodes: the next one in the queue */
+            T                   value;
+        };
+
+        typedef typename Alloc::template rebind<node>::other    AllocNode;
+
+        /* the count slots retired after the previous batch, up to tp */
+
+        struct stamp
+        {
+            typename Time::time_point tp;
+            index count;
+        };
+
+    public:
+
+        struct _const_list_iterator;
+
+        struct _list_iterator : std::iterator<std::forward_iterator_tag, T>
+        {
+            friend struct _const_list_iterator;
+
+            _list_iterator()
+            : base_(nullptr)
+            , idx_(npos)
+            {}
+
+            _list_iterator(node *base, index i)
+            : base_(base)
+            , idx_(i)
+            {}
+
+            reference
+            operator*() const
+            {
+                return base_[idx_].value;
+            }
+
+            pointer
+            operator->() const
+            {
+                return &base_[idx_].value;
+            }
+
+            _list_iterator &
+            operator++()
+            {
+                idx_ = base_[idx_].next.load(std::memory_order_acquire);
+                return *this;
+            }
+
+            _list_iterator
+            operator++(int)
+            {
+                auto self = *this;
+                ++*this;
+                return self;
+            }
+
+            bool
+            operator==(const _list_iterator &it)
+            {
+                return idx_ == it.idx_;
+            }
+
+            bool
+            operator!=(const _list_iterator &it)
+            {
+                return idx_ != it.idx_;
+            }
+
+            node * base_;
+            index idx_;
+        };
+
+        struct _const_list_iterator : std::iterator<std::forward_iterator_tag, const T>
+        {
+            _const_list_iterator()
+            : base_(nullptr)
+            , idx_(npos)
+            {}
+
+            _const_list_iterator(node *base, index i)
+            : base_(base)
+            , idx_(i)
+            {}
+
+            _const_list_iterator(const _list_iterator &it)
+            : base_(it.base_)
+            , idx_(it.idx_)
+            {}
+
+            const_reference
+            operator*() const
+            {
+                return base_[idx_].value;
+            }
+
+            const_pointer
+            operator->() const
+            {
+                return &base_[idx_].value;
+            }
+
+            _const_list_iterator &
+            operator++()
+            {
+                idx_ = base_[idx_].next.load(std::memory_order_acquire);
+                return *this;
+            }
+
+            _const_list_iterator
+            operator++(int)
+            {
+                auto self = *this;
+                ++*this;
+                return self;
+            }
+
+            bool
+            operator==(const _const_list_iterator &it)
+            {
+                return idx_ == it.idx_;
+            }
+
+            bool
+            operator!=(const _const_list_iterator &it)
+            {
+                return idx_ != it.idx_;
+            }
+
+            node * base_;
+            index idx_;
+        };
+
+        typedef _list_iterator           iterator;
+        typedef _const_list_iterator     const_iterator;
+
+    public:
+
+        /* thread unsafe: to be called with no traversing visitors */
+
+        explicit shared_compact_list(size_type capacity, const Alloc & alloc = Alloc())
+        : alloc_(alloc)
+        , cap_(static_cast<index>(capacity))
+        , node_(nullptr)
+        , head_(npos)
+        , tail_(npos)
+        , free_(npos)
+        , ptr_(npos)
+        , last_(npos)
+        , stamps_()
+        , size_(0)
+        , grace_()
+        {
+            if (capacity >= npos)
+                throw std::length_error("shared_compact_list: capacity");
+
+            node_ = AllocNode(alloc_).allocate(cap_ ? cap_ : 1);
+
+            /* all the slots start on the free list */
+
+            for(index i = 0; i < cap_; i++)
+            {
+                new (&node_[i].next) std::atomic<index>(npos);
+                node_[i].prev = i + 1 < cap_ ? i + 1 : npos;
+            }
+
+            free_ = cap_ ? 0 : npos;
+        }
+
+        shared_compact_list(size_type capacity, std::chrono::nanoseconds grace, const Alloc & alloc = Alloc())
+        : shared_compact_list(capacity, alloc)
+        {
+            grace_.set(grace);
+        }
+
+        shared_compact_list(const shared_compact_list &) = delete;
+        shared_compact_list& operator=(const shared_compact_list &) = delete;
+
+        /* the array is freed after the grace period of the last nodes */
+
+        ~shared_compact_list()
+        {
+            this->clear();
+
+            while (ptr_ != npos)
+            {
+                if (flush_() == 0)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
+            }
+
+            AllocNode(alloc_).deallocate(node_, cap_ ? cap_ : 1);
+        }
+
+        /***** single writer *****/
+
+        /* the expired slots are taken back first, std::length_error if
+         * none is free */
+
+        void push_back(const T &value)
+        {
+            insert_node_(npos, new_node_(value));
+        }
+
+        void push_front(const T &value)
+        {
+            insert_node_(head_.load(std::memory_order_relaxed), new_node_(value));
+        }
+
+        iterator insert(const_iterator pos, const T &value)
+        {
+            auto n = new_node_(value);
+            insert_node_(pos.idx_, n);
+            return iterator(node_, n);
+        }
+
+        void pop_front()
+        {
+            unlink_(head_.load(std::memory_order_relaxed));
+        }
+
+        void pop_back()
+        {
+            unlink_(tail_);
+        }
+
+        iterator erase(const_iterator pos)
+        {
+            return iterator(node_, unlink_(pos.idx_));
+        }
+
+        void clear()
+        {
+            while (tail_ != npos)
+                unlink_(tail_);
+        }
+
+        /* move the expired slots to the free list */
+
+        size_type shrink()
+        {
+            return flush_();
+        }
+
+        /* thread unsafe: to be called with no readers. All the slots are
+         * free again at once */
+
+        void dispose()
+        {
+            head_.store(npos, std::memory_order_relaxed);
+            tail_ = ptr_ = last_ = npos;
+            stamps_.clear();
+
+            for(index i = 0; i < cap_; i++)
+            {
+                node_[i].next.store(npos, std::memory_order_relaxed);
+                node_[i].prev = i + 1 < cap_ ? i + 1 : npos;
+            }
+
+            free_ = cap_ ? 0 : npos;
+            size_.store(0, std::memory_order_relaxed);
+        }
+
+        /* per-list grace period, for the time policies */
+
+        typename Time::duration
+        grace_period() const
+        {
+            return grace_.get();
+        }
+
+        void grace_period(std::chrono::nanoseconds d)
+        {
+            grace_.set(d);
+        }
+
+        /* retired slots not reusable yet, readable by any thread */
+
+        size_type garbage_size() const noexcept
+        {
+            return size_.load(std::memory_order_relaxed);
+        }
+
+        size_type capacity() const noexcept
+        {
+            return cap_;
+        }
+
+        /***** shared and thread-safe: only affected by data-race on T (to be handled by user-code) *****/
+
+        iterator
+        begin()
+        {
+            return iterator(node_, head_.load(std::memory_order_acquire));
+        }
+
+        const_iterator
+        begin() const
+        {
+            return const_iterator(node_, head_.load(std::memory_order_acquire));
+        }
+
+        iterator
+        end()
+        {
+            return iterator();
+        }
+
+        const_iterator
+        end() const
+        {
+            return const_iterator();
+        }
+
+        const_iterator
+        cbegin() const
+        {
+            return begin();
+        }
+
+        const_iterator
+        cend() const
+        {
+            return end();
+        }
+
+        reference front()
+        {
+            return node_[head_.load(std::memory_order_acquire)].value;
+        }
+
+        const_reference front() const
+        {
+            return node_[head_.load(std::memory_order_acquire)].value;
+        }
+
+        reference back()
+        {
+            return node_[tail_].value;
+        }
+
+        const_reference back() const
+        {
+            return node_[tail_].value;
+        }
+
+        bool empty() const noexcept
+        {
+            return head_.load(std::memory_order_relaxed) == npos;
+        }
+
+        size_type size() const noexcept
+        {
+            size_type c = 0;
+            for(auto i = head_.load(std::memory_order_relaxed); i != npos; i = node_[i].next.load(std::memory_order_relaxed))
+                c++;
+            return c;
+        }
+
+        Alloc get_allocator() const noexcept
+        {
+            return alloc_;
+        }
+
+    private:
+
+        index
+        new_node_(const T &value)
+        {
+            if (free_ == npos)
+                flush_();
+
+            if (free_ == npos)
+                throw std::length_error("shared_compact_list: full");
+
+            auto n = free_;
+            free_ = node_[n].prev;
+            node_[n].value = value;
+            return n;
+        }
+
+        void
+        insert_node_(index pos, index n)
+        {
+            auto &x = node_[n];
+
+            if (pos == npos) {
+                x.next.store(npos, std::memory_order_relaxed);
+                x.prev = tail_;
+                if (tail_ != npos)
+                    node_[tail_].next.store(n, std::memory_order_release);
+                else
+                    head_.store(n, std::memory_order_release);
+                tail_ = n;
+            }
+            else {
+                auto &p = node_[pos];
+                x.next.store(pos, std::memory_order_relaxed);
+                x.prev = p.prev;
+                if (p.prev != npos)
+                    node_[p.prev].next.store(n, std::memory_order_release);
+                else
+                    head_.store(n, std::memory_order_release);
+                p.prev = n;
+            }
+        }
+
+        /* returns the index that followed */
+
+        index
+        unlink_(index i)
+        {
+            auto &x = node_[i];
+            auto next = x.next.load(std::memory_order_relaxed);
+
+            if (x.prev != npos)
+                node_[x.prev].next.store(next, std::memory_order_release);
+            else
+                head_.store(next, std::memory_order_release);
+
+            if (next != npos)
+                node_[next].prev = x.prev;
+            else
+                tail_ = x.prev;
+
+            retire_(i);
+            return next;
+        }
+
+        /* retired slots are queued through prev, oldest first; their next
+         * is left untouched for the readers still standing on them. The
+         * open batch takes the stamp of every slot joining it, and a scan
+         * runs whenever a batch is closed */
+
+        void
+        retire_(index i)
+        {
+            node_[i].prev = npos;
+
+            if (last_ != npos)
+                node_[last_].prev = i;
+            else
+                ptr_ = i;
+
+            last_ = i;
+            count_(1);
+
+            if (stamps_.empty() || stamps_.back().count >= defaults::scan_threshold)
+                stamps_.push_back(stamp { Time::now(), 1 });
+            else
+            {
+                stamps_.back().tp = Time::now();
+                if (++stamps_.back().count == defaults::scan_threshold)
+                    flush_();
+            }
+        }
+
+        size_type
+        flush_()
+        {
+            grace_.update();
+
+            if (ptr_ == npos)
+                return 0;
+
+            auto h = Time::horizon();
+            size_type ret = 0;
+
+            while (!stamps_.empty() && grace_.expired(&stamps_.front(), h))
+            {
+                for(auto n = stamps_.front().count; n != 0; n--)
+                {
+                    auto i = ptr_;
+                    ptr_ = node_[i].prev;
+
+                    node_[i].prev = free_;
+                    free_ = i;
+                    ret++;
+                }
+
+                stamps_.pop_front();
+            }
+
+            if (ptr_ == npos)
+                last_ = npos;
+
+            count_(-static_cast<std::ptrdiff_t>(ret));
+            return ret;
+        }
+
+        void
+        count_(std::ptrdiff_t n)
+        {
+            size_.store(size_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+        }
+
+        Alloc alloc_;
+        index cap_;
+
+        node * node_;
+
+        std::atomic<index> head_;
+        index tail_;
+        index free_;
+
+        index ptr_;
+        index last_;
+        std::deque<stamp> stamps_;
+        std::atomic<size_t> size_;
+
+        detail::grace_of<Time> grace_;
+    };
+}
+
+#endif /* __SHARED_COMPACT_LIST_HPP__ */
@@ -0,0 +1,199 @@
+/*
+ *  Copyright (c) 2011-2014 Bonelli Nicola <nicola.bonelli@cnit.it>
+ *                          Loris Gazzarrini <loris.gazzarrini@for.iet.unipi.it>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef __SHARED_DISPOSER_HPP__
+#define __SHARED_DISPOSER_HPP__
+
+#include <atomic>
+#include <vector>
+#include <deque>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+namespace more {
+
+    /////////////////////// Default disposer settings:
+
+    namespace defaults
+    {
+        /* batches a disposer holds before writers fall back to inline destruction */
+
+        const constexpr size_t dispose_queue = 1024;
+
+        /* expired nodes a container collects before handing them over */
+
+        const constexpr size_t dispose_batch = 64;
+    }
+
+    ///////////////////// disposer
+    //
+    // Deferred destruction service: containers attached to it hand over
+    // batches of expired nodes instead of destroying them inline, so that
+    // the destructors of T and the deallocation run in the worker threads,
+    // off the writer path. The queue is bounded: when it is full post()
+    // fails and the caller destroys the batch itself.
+    //
+
+    class disposer
+    {
+    public:
+
+        typedef void (*function)(void *ctx, void *batch);
+
+        explicit disposer(size_t capacity = defaults::dispose_queue, size_t threads = 1)
+        : capacity_(capacity)
+        , stop_(false)
+        , running_(0)
+        , posted_(0)
+        , rejected_(0)
+        , disposed_(0)
+        {
+            for(size_t i = 0; i < threads; i++)
+                threads_.emplace_back(&disposer::run_, this);
+        }
+
+        /* pending batches are disposed of before returning */
+
+        ~disposer()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+
+            cond_.notify_all();
+
+            for(auto &t : threads_)
+                t.join();
+        }
+
+        disposer(const disposer &) = delete;
+        disposer& operator=(const disposer &) = delete;
+
+        /* fun(ctx, batch) destroys the n nodes of the batch */
+
+        bool post(function fun, void *ctx, void *batch, size_t n)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                if (queue_.size() >= capacity_ || stop_)
+                {
+                    rejected_.fetch_add(1, std::memory_order_relaxed);
+                    return false;
+                }
+
+                queue_.push_back(job{fun, ctx, batch, n});
+            }
+
+            posted_.fetch_add(1, std::memory_order_relaxed);
+            cond_.notify_one();
+            return true;
+        }
+
+        /* wait for the batches posted so far */
+
+        void wait()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+            done_.wait(lock, [this] { return queue_.empty() && running_ == 0; });
+        }
+
+        size_t posted() const
+        {
+            return posted_.load(std::memory_order_relaxed);
+        }
+
+        size_t rejected() const
+        {
+            return rejected_.load(std::memory_order_relaxed);
+        }
+
+        size_t disposed() const
+        {
+            return disposed_.load(std::memory_order_relaxed);
+        }
+
+        size_t pending()
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            return queue_.size();
+        }
+
+        size_t capacity() const
+        {
+            return capacity_;
+        }
+
+    private:
+
+        struct job
+        {
+            function    fun;
+            void *      ctx;
+            void *      batch;
+            size_t      size;
+        };
+
+        void run_()
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+
+            for(;;)
+            {
+                cond_.wait(lock, [this] { return stop_ || !queue_.empty(); });
+
+                if (queue_.empty())
+                    break;
+
+                auto j = queue_.front();
+                queue_.pop_front();
+                running_++;
+
+                lock.unlock();
+
+                j.fun(j.ctx, j.batch);
+                disposed_.fetch_add(j.size, std::memory_order_relaxed);
+
+                lock.lock();
+
+                running_--;
+                done_.notify_all();
+            }
+        }
+
+        size_t capacity_;
+
+        std::mutex mutex_;
+        std::condition_variable cond_;
+        std::condition_variable done_;
+        std::deque<job> queue_;
+        bool stop_;
+        size_t running_;
+
+        std::atomic<size_t> posted_;
+        std::atomic<size_t> rejected_;
+        std::atomic<size_t> disposed_;
+
+        std::vector<std::thread> threads_;
+    };
+}
+
+#endif /* __SHARED_DISPOSER_HPP__ */
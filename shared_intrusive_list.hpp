@@ -0,0 +1,571 @@
+/*
+ *  Copyright (c) 2011-2014 Bonelli Nicola <nicola.bonelli@cnit.it>
+ *                          Loris Gazzarrini <loris.gazzarrini@for.iet.unipi.it>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef __SHARED_INTRUSIVE_LIST_HPP__
+#define __SHARED_INTRUSIVE_LIST_HPP__
+
+#include <shared_list.hpp>
+
+namespace more {
+
+    ///////////////////// shared_list_hook
+    //
+    // Member hook of the objects linked into a shared_intrusive_list: the
+    // links, the retirement stamp and a pointer back to the object live in
+    // the object, so that linking it takes no allocation and no copy. The
+    // hook is a node of the shared domain, so erased objects go through the
+    // same garbage queue as the elements of a shared_list. Copying an
+    // object does not copy its links.
+    //
+
+    template <typename Time = TimeStampCounter>
+    struct shared_list_hook : detail::shared_node<void *, Time>
+    {
+        shared_list_hook()
+        {
+            this->next.store(nullptr, std::memory_order_relaxed);
+            this->value = nullptr;
+            this->tp    = typename Time::time_point();
+            this->prev  = nullptr;
+        }
+
+        shared_list_hook(const shared_list_hook &)
+        : shared_list_hook()
+        {}
+
+        shared_list_hook& operator=(const shared_list_hook &)
+        {
+            return *this;
+        }
+    };
+
+    namespace detail
+    {
+        /* node allocator of the intrusive lists: the storage belongs to the
+         * user, deallocating a hook hands its object to the release
+         * function instead. Nodes are never allocated through it */
+
+        template <typename T>
+        struct hook_allocator : std::allocator<T>
+        {
+            typedef void (*release_type)(void *, void *);
+
+            template <typename U>
+            struct rebind
+            {
+                typedef hook_allocator<U> other;
+            };
+
+            hook_allocator(release_type fun = nullptr, void *ctx = nullptr) noexcept
+            : fun_(fun)
+            , ctx_(ctx)
+            {}
+
+            template <typename U>
+            hook_allocator(hook_allocator<U> const &other) noexcept
+            : fun_(other.fun_)
+            , ctx_(other.ctx_)
+            {}
+
+            void deallocate(T *p, std::size_t)
+            {
+                if (fun_)
+                    fun_(ctx_, p);
+            }
+
+            release_type fun_;
+            void * ctx_;
+        };
+
+        template <typename T>
+        struct pool_traits<hook_allocator<T>>
+        {
+            static constexpr bool enabled = false;
+        };
+    }
+
+    ///////////////////// shared_intrusive_list
+    //
+    // Single writer and lock-free readers, as in shared_list, over objects
+    // owned by the user. An erased object is handed to the release function
+    // once no reader can reach it any longer (e.g. to give it back to its
+    // pool): until then it must be neither destroyed nor linked again. An
+    // object is linked into one list at a time. Every erase releases the
+    // objects expired so far: none is kept back, as nothing is allocated
+    // from the garbage here.
+    //
+
+    template <typename T, typename Time, shared_list_hook<Time> T::*Hook>
+    struct shared_intrusive_list
+    {
+
+    public:
+
+        typedef T                                   value_type;
+        typedef std::size_t                         size_type;
+        typedef std::ptrdiff_t                      difference_type;
+
+        typedef value_type &                        reference;
+        typedef const value_type &                  const_reference;
+        typedef value_type *                        pointer;
+        typedef const value_type *                  const_pointer;
+
+        typedef std::function<void(T *)>            release_type;
+
+    private:
+
+        typedef detail::hook_allocator<void *>                alloc_type;
+        typedef detail::shared_domain<void *, Time, alloc_type> domain_type;
+        typedef typename domain_type::node                    node;
+        typedef typename detail::hazard_of<Time>::type        hazard_type;
+
+        /* the object a hook is embedded in, stored when it is linked */
+
+        static T *
+        object_(node *n)
+        {
+            return static_cast<T *>(n->value);
+        }
+
+    public:
+
+        struct _const_list_iterator;
+
+        struct _list_iterator : std::iterator<std::forward_iterator_tag, T>, private hazard_type
+        {
+            friend struct _const_list_iterator;
+
+            _list_iterator()
+            : node_(nullptr)
+            {}
+
+            explicit _list_iterator(node *p)
+            : node_(this->publish(p))
+            {}
+
+            explicit _list_iterator(std::atomic<node *> const &src)
+            : node_(this->protect(src))
+            {}
+
+            reference
+            operator*() const
+            {
+                return *object_(node_);
+            }
+
+            pointer
+            operator->() const
+            {
+                return object_(node_);
+            }
+
+            _list_iterator &
+            operator++()
+            {
+                node_ = this->protect(node_->next);
+                return *this;
+            }
+
+            _list_iterator
+            operator++(int)
+            {
+                auto self = *this;
+                node_ = this->protect(node_->next);
+                return self;
+            }
+
+            bool
+            operator==(const _list_iterator &it)
+            {
+                return node_ == it.node_;
+            }
+
+            bool
+            operator!=(const _list_iterator &it)
+            {
+                return node_ != it.node_;
+            }
+
+            node * node_;
+        };
+
+
+        struct _const_list_iterator : std::iterator<std::forward_iterator_tag, const T>, private hazard_type
+        {
+            _const_list_iterator()
+            : node_(nullptr)
+            {}
+
+            explicit _const_list_iterator(node *p)
+            : node_(this->publish(p))
+            {}
+
+            explicit _const_list_iterator(std::atomic<node *> const &src)
+            : node_(this->protect(src))
+            {}
+
+            _const_list_iterator(const _list_iterator &it)
+            : hazard_type(static_cast<hazard_type const &>(it))
+            , node_(it.node_)
+            {}
+
+            const_reference
+            operator*() const
+            {
+                return *object_(node_);
+            }
+
+            const_pointer
+            operator->() const
+            {
+                return object_(node_);
+            }
+
+            _const_list_iterator &
+            operator++()
+            {
+                node_ = this->protect(node_->next);
+                return *this;
+            }
+
+            _const_list_iterator
+            operator++(int)
+            {
+                auto self = *this;
+                node_ = this->protect(node_->next);
+                return self;
+            }
+
+            bool
+            operator==(const _const_list_iterator &it)
+            {
+                return node_ == it.node_;
+            }
+
+            bool
+            operator!=(const _const_list_iterator &it)
+            {
+                return node_ != it.node_;
+            }
+
+            node * node_;
+        };
+
+        typedef _list_iterator           iterator;
+        typedef _const_list_iterator     const_iterator;
+
+    public:
+
+        /* thread unsafe: to be called with no traversing visitors */
+
+        explicit shared_intrusive_list(release_type release = release_type())
+        : head_(nullptr)
+        , tail_(nullptr)
+        , release_(std::move(release))
+        , domain_(alloc_type(&release_node_, this))
+        {}
+
+        explicit shared_intrusive_list(std::chrono::nanoseconds grace, release_type release = release_type())
+        : shared_intrusive_list(std::move(release))
+        {
+            domain_.grace_period(grace);
+        }
+
+        shared_intrusive_list(const shared_intrusive_list &) = delete;
+        shared_intrusive_list& operator=(const shared_intrusive_list &) = delete;
+
+        /* the objects still linked are released after the grace period */
+
+        ~shared_intrusive_list()
+        {
+            this->detach();
+            this->clear();
+        }
+
+        /* background reclamation: release is then called by the reclaimer
+         * thread */
+
+        void attach(reclaimer &r)
+        {
+            domain_.attach(r);
+        }
+
+        void detach()
+        {
+            domain_.detach();
+        }
+
+        /***** single writer *****/
+
+        void push_back(T &obj)
+        {
+            insert_node_(nullptr, link_(obj));
+        }
+
+        void push_front(T &obj)
+        {
+            insert_node_(head_.load(std::memory_order_relaxed), link_(obj));
+        }
+
+        iterator insert(const_iterator pos, T &obj)
+        {
+            auto n = link_(obj);
+            insert_node_(pos.node_, n);
+            return iterator(n);
+        }
+
+        void pop_front()
+        {
+            unlink_(head_.load(std::memory_order_relaxed));
+        }
+
+        void pop_back()
+        {
+            unlink_(tail_);
+        }
+
+        iterator erase(const_iterator pos)
+        {
+            return iterator(unlink_(pos.node_));
+        }
+
+        /* the objects are retired in list order, as a single chain */
+
+        void clear()
+        {
+            auto h = head_.exchange(nullptr, std::memory_order_relaxed);
+            auto t = tail_;
+            tail_ = nullptr;
+
+            size_type n = 0;
+            for(auto p = h; p != nullptr; n++)
+            {
+                auto next = p->next.load(std::memory_order_relaxed);
+                p->prev = next;
+                p = next;
+            }
+
+            if (n)
+                domain_.retire_chain(h, t, n);
+        }
+
+        /* release the objects whose grace period has elapsed */
+
+        size_type shrink()
+        {
+            auto n = domain_.flush();
+            return n < 0 ? 0 : n;
+        }
+
+        /* to be called by the writer: waits for the readers that could
+         * have seen an object erased before the call */
+
+        void synchronize()
+        {
+            domain_.synchronize();
+        }
+
+        /* thread unsafe: to be called with no readers. Linked and erased
+         * objects are released immediately */
+
+        void dispose()
+        {
+            auto h = head_.exchange(nullptr, std::memory_order_relaxed);
+            tail_ = nullptr;
+            domain_.destroy_list(h);
+            domain_.purge();
+        }
+
+        /* per-list grace period, for the time policies */
+
+        typename Time::duration
+        grace_period() const
+        {
+            return domain_.grace_period();
+        }
+
+        void grace_period(std::chrono::nanoseconds d)
+        {
+            domain_.grace_period(d);
+        }
+
+        /* erased objects not released yet, readable by any thread */
+
+        size_type garbage_size() const noexcept
+        {
+            return domain_.garbage_size();
+        }
+
+        /***** shared and thread-safe *****/
+
+        iterator
+        begin()
+        {
+            return _list_iterator(head_);
+        }
+
+        const_iterator
+        begin() const
+        {
+            return _const_list_iterator(head_);
+        }
+
+        iterator
+        end()
+        {
+            return _list_iterator();
+        }
+
+        const_iterator
+        end() const
+        {
+            return _const_list_iterator();
+        }
+
+        const_iterator
+        cbegin() const
+        {
+            return _const_list_iterator(head_);
+        }
+
+        const_iterator
+        cend() const
+        {
+            return _const_list_iterator();
+        }
+
+        reference front()
+        {
+            return *object_(head_.load(std::memory_order_acquire));
+        }
+
+        const_reference front() const
+        {
+            return *object_(head_.load(std::memory_order_acquire));
+        }
+
+        reference back()
+        {
+            return *object_(tail_);
+        }
+
+        const_reference back() const
+        {
+            return *object_(tail_);
+        }
+
+        bool empty() const noexcept
+        {
+            return head_.load(std::memory_order_relaxed) == nullptr;
+        }
+
+        size_type size() const noexcept
+        {
+            size_type c = 0;
+            for(auto n = head_.load(std::memory_order_relaxed); n != nullptr; n = n->next.load(std::memory_order_relaxed))
+                c++;
+            return c;
+        }
+
+    private:
+
+        /* a linked hook points back to its object, and carries no stamp
+         * until it is retired */
+
+        static node *
+        link_(T &obj)
+        {
+            node *n = &(obj.*Hook);
+            n->value = &obj;
+            n->tp    = typename Time::time_point();
+            return n;
+        }
+
+        void
+        insert_node_(node *pos, node *n)
+        {
+            if (pos == nullptr) {
+                n->next.store(nullptr, std::memory_order_relaxed);
+                n->prev = tail_;
+                if (tail_)
+                    tail_->next.store(n, std::memory_order_release);
+                else
+                    head_.store(n, std::memory_order_release);
+                tail_ = n;
+            }
+            else {
+                n->next.store(pos, std::memory_order_relaxed);
+                n->prev = pos->prev;
+                if (pos->prev)
+                    pos->prev->next.store(n, std::memory_order_release);
+                else
+                    head_.store(n, std::memory_order_release);
+                pos->prev = n;
+            }
+        }
+
+        /* returns the node that followed */
+
+        node *
+        unlink_(node *that)
+        {
+            auto next = that->next.load(std::memory_order_relaxed);
+
+            if (that->prev)
+                that->prev->next.store(next, std::memory_order_release);
+            else
+                head_.store(next, std::memory_order_release);
+
+            if (next)
+                next->prev = that->prev;
+            else
+                tail_ = that->prev;
+
+            domain_.retire(that, false);
+            return next;
+        }
+
+        /* called by the domain in place of deallocating the hook */
+
+        static void
+        release_node_(void *ctx, void *p)
+        {
+            auto self = static_cast<shared_intrusive_list *>(ctx);
+            auto n    = static_cast<node *>(p);
+            auto obj  = object_(n);
+
+            n->next.store(nullptr, std::memory_order_relaxed);
+            n->prev  = nullptr;
+            n->value = nullptr;
+
+            if (self->release_)
+                self->release_(obj);
+        }
+
+        std::atomic<node *> head_;
+        node * tail_;
+
+        release_type release_;
+
+        domain_type domain_;
+    };
+}
+
+#endif /* __SHARED_INTRUSIVE_LIST_HPP__ */
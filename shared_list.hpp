@@ -26,88 +26,2882 @@
 #include <initializer_list>
 #include <iterator>
 #include <chrono>
-#include <fstream>
 #include <algorithm>
 #include <vector>
+#include <deque>
 #include <thread>
 #include <iostream>
+#include <cstdint>
+#include <limits>
+#include <functional>
+
+#include <time.h>
+
+#if defined(__linux__)
+#include <linux/mempolicy.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#if !defined(MORE_NO_MEMBARRIER)
+#include <linux/membarrier.h>
+#endif
+#endif
+
+#include <shared_reclaimer.hpp>
+#include <shared_disposer.hpp>
+
+namespace more {
+
+    /////////////////////// Default grace period:
+
+    namespace defaults
+    {
+        const constexpr std::chrono::milliseconds grace_period {100};
+
+        /* time spent measuring the TSC frequency */
+
+        const constexpr std::chrono::milliseconds tsc_calibration {10};
+
+        /* retirements between two scans, for policies that are not ordered */
+
+        const constexpr size_t scan_threshold = 64;
+
+        /* destroyed nodes kept by each container for reuse */
+
+        const constexpr size_t pool_capacity = 1024;
+
+        /* nodes carved from each chunk of a slab_allocator */
+
+        const constexpr size_t slab_nodes = 256;
+
+        /* size of the pages backing a huge_page_allocator */
+
+        const constexpr size_t huge_page = 2 << 20;
+
+        /* adaptive grace period: percentile of the sampled read latency,
+         * the margin it is multiplied by, and the lower bound */
+
+        const constexpr double read_percentile = 0.999;
+
+        const constexpr double read_margin = 4.0;
+
+        const constexpr std::chrono::microseconds read_grace_floor {100};
+    }
+
+    /////////////////////// Reclamation Policies:
+    //
+    // A policy stamps every node retired by a writer (now) and decides
+    // when it can be reclaimed: horizon() takes a snapshot of the readers
+    // state and expired(node, horizon) tells whether the node is still
+    // reachable by any of them. Ordered policies expire nodes in the same
+    // order they are retired.
+    //
+
+    /////////////////////// Time Policies:
+
+    struct TimeStampCounter
+    {
+        typedef unsigned long long time_point;
+        typedef unsigned long long duration;
+
+        static constexpr bool ordered = true;
+
+        /* rdtscp waits for the preceding instructions: the stamp of a
+         * retired node is not taken before it is unlinked */
+
+        static time_point
+        now()
+        {
+#if defined(__x86_64__) || defined(__i386__)
+            unsigned int __a, __d, __c;
+            __asm__ __volatile__("rdtscp" : "=a" (__a), "=d" (__d), "=c" (__c) :: "memory");
+            return ((time_point)__a) | (((time_point)__d)<<32);
+#else
+            timespec ts;
+            clock_gettime(CLOCK_MONOTONIC, &ts);
+            return static_cast<time_point>(ts.tv_sec) * 1000000000 + ts.tv_nsec;
+#endif
+        }
+
+        /* measure the TSC frequency against CLOCK_MONOTONIC: to be called
+         * at startup, otherwise the first grace_period() pays for it */
+
+        static void
+        init(std::chrono::milliseconds span = defaults::tsc_calibration)
+        {
+            typedef typename std::decay<decltype(defaults::grace_period)>::type duration_type;
+
+            auto hz = calibrate(span);
+            frequency_().store(hz, std::memory_order_relaxed);
+            ticks_().store(hz * defaults::grace_period.count() / duration_type(std::chrono::seconds(1)).count(),
+                           std::memory_order_relaxed);
+        }
+
+        /* ticks per second */
+
+        static uint64_t
+        frequency()
+        {
+            auto hz = frequency_().load(std::memory_order_relaxed);
+            if (hz == 0)
+            {
+                init();
+                hz = frequency_().load(std::memory_order_relaxed);
+            }
+            return hz;
+        }
+
+        static duration
+        grace_period()
+        {
+            auto t = ticks_().load(std::memory_order_relaxed);
+            if (t == 0)
+            {
+                init();
+                t = ticks_().load(std::memory_order_relaxed);
+            }
+            return t;
+        }
+
+        static time_point
+        horizon()
+        {
+            return now();
+        }
+
+        template <typename Node>
+        static bool
+        expired(Node const *p, time_point now)
+        {
+            return now - p->tp > grace_period();
+        }
+
+        template <typename Node>
+        static bool
+        expired(Node const *p, time_point now, duration grace)
+        {
+            return now - p->tp > grace;
+        }
+
+        static duration
+        ticks(std::chrono::nanoseconds d)
+        {
+            return static_cast<duration>(static_cast<long double>(frequency()) * d.count() / 1000000000);
+        }
+
+        static uint64_t
+        calibrate(std::chrono::milliseconds span)
+        {
+            timespec t0, t1;
+            uint64_t ns;
+
+            clock_gettime(CLOCK_MONOTONIC, &t0);
+            auto c0 = now();
+
+            do
+            {
+                clock_gettime(CLOCK_MONOTONIC, &t1);
+                ns = static_cast<uint64_t>(t1.tv_sec - t0.tv_sec) * 1000000000 + t1.tv_nsec - t0.tv_nsec;
+            }
+            while (ns < static_cast<uint64_t>(std::chrono::nanoseconds(span).count()));
+
+            auto c1 = now();
+
+            return static_cast<uint64_t>(static_cast<long double>(c1 - c0) * 1000000000 / ns);
+        }
+
+    private:
+
+        static std::atomic<uint64_t> &
+        frequency_()
+        {
+            static std::atomic<uint64_t> hz(0);
+            return hz;
+        }
+
+        static std::atomic<uint64_t> &
+        ticks_()
+        {
+            static std::atomic<uint64_t> t(0);
+            return t;
+        }
+    };
+
+    struct TimePoint
+    {
+        typedef std::chrono::high_resolution_clock::time_point   time_point;
+        typedef std::chrono::high_resolution_clock::duration     duration;
+
+        static constexpr bool ordered = true;
+
+        static time_point
+        now()
+        {
+            return std::chrono::high_resolution_clock::now();
+        }
+
+        static duration
+        grace_period()
+        {
+            return defaults::grace_period;
+        }
+
+        static time_point
+        horizon()
+        {
+            return now();
+        }
+
+        template <typename Node>
+        static bool
+        expired(Node const *p, time_point now)
+        {
+            return now - p->tp > grace_period();
+        }
+
+        template <typename Node>
+        static bool
+        expired(Node const *p, time_point now, duration grace)
+        {
+            return now - p->tp > grace;
+        }
+
+        static duration
+        ticks(std::chrono::nanoseconds d)
+        {
+            return std::chrono::duration_cast<duration>(d);
+        }
+    };
+
+    /////////////////////// Asymmetric fences:
+    //
+    // A reader publishing its state and the writer scanning it need a full
+    // fence on both sides. On Linux the writer side can instead run
+    // membarrier(MEMBARRIER_CMD_PRIVATE_EXPEDITED), which serializes every
+    // running thread of the process, and the reader side is reduced to a
+    // compiler barrier. Elsewhere, when the kernel lacks the command, or if
+    // MORE_NO_MEMBARRIER is defined, both sides use a seq_cst fence.
+    //
+
+    namespace detail
+    {
+        struct asymmetric_fence
+        {
+            /* reader side */
+
+            static void
+            light()
+            {
+                if (expedited())
+                    std::atomic_signal_fence(std::memory_order_seq_cst);
+                else
+                    std::atomic_thread_fence(std::memory_order_seq_cst);
+            }
+
+            /* writer side */
+
+            static void
+            heavy()
+            {
+#if defined(__linux__) && !defined(MORE_NO_MEMBARRIER)
+                if (expedited() && syscall(__NR_membarrier, MEMBARRIER_CMD_PRIVATE_EXPEDITED, 0) == 0)
+                    return;
+#endif
+                std::atomic_thread_fence(std::memory_order_seq_cst);
+            }
+
+            /* the process is registered once, before any reader relies on it */
+
+            static bool
+            expedited()
+            {
+                static const bool on = register_();
+                return on;
+            }
+
+        private:
+
+            static bool
+            register_()
+            {
+#if defined(__linux__) && !defined(MORE_NO_MEMBARRIER)
+                auto cmds = syscall(__NR_membarrier, MEMBARRIER_CMD_QUERY, 0);
+                if (cmds < 0 || !(cmds & MEMBARRIER_CMD_PRIVATE_EXPEDITED))
+                    return false;
+
+                return syscall(__NR_membarrier, MEMBARRIER_CMD_REGISTER_PRIVATE_EXPEDITED, 0) == 0;
+#else
+                return false;
+#endif
+            }
+        };
+    }
+
+    /////////////////////// Epoch Based Reclamation:
+
+    namespace detail
+    {
+        /* per-thread reader state, on a cache line of its own */
+
+        struct alignas(64) reader_record
+        {
+            std::atomic<uint64_t>       epoch;
+            reader_record *             next;
+            unsigned int                nesting;
+            std::atomic<bool>           in_use;
+
+            void reset()
+            {
+                epoch.store(0, std::memory_order_release);
+                nesting = 0;
+            }
+        };
+
+        /* registry of reader records: records are never freed, but recycled
+         * when released (i.e. when the owner thread exits) */
+
+        template <typename Tag, typename Record = reader_record>
+        struct reader_registry
+        {
+            static std::atomic<Record *> &
+            head()
+            {
+                static std::atomic<Record *> h(nullptr);
+                return h;
+            }
+
+            static Record &
+            local()
+            {
+                static thread_local holder h;
+                return *h.rec;
+            }
+
+            template <typename Fun>
+            static void
+            for_each(Fun fun)
+            {
+                for(auto r = head().load(std::memory_order_acquire); r != nullptr; r = r->next)
+                {
+                    if (r->in_use.load(std::memory_order_relaxed))
+                        fun(*r);
+                }
+            }
+
+            static Record *
+            acquire()
+            {
+                for(auto r = head().load(std::memory_order_acquire); r != nullptr; r = r->next)
+                {
+                    bool free = false;
+                    if (!r->in_use.load(std::memory_order_relaxed) &&
+                         r->in_use.compare_exchange_strong(free, true, std::memory_order_acq_rel))
+                    {
+                        r->reset();
+                        return r;
+                    }
+                }
+
+                auto r = make_();
+                r->reset();
+                r->in_use.store(true, std::memory_order_relaxed);
+
+                auto h = head().load(std::memory_order_relaxed);
+                do {
+                    r->next = h;
+                }
+                while (!head().compare_exchange_weak(h, r, std::memory_order_release, std::memory_order_relaxed));
+
+                return r;
+            }
+
+            static void
+            release(Record *r)
+            {
+                r->reset();
+                r->in_use.store(false, std::memory_order_release);
+            }
+
+        private:
+
+            /* records are never freed: their storage is aligned by hand,
+             * as new does not honour over-aligned types before C++17 */
+
+            static Record *
+            make_()
+            {
+                auto a   = alignof(Record);
+                auto raw = reinterpret_cast<std::uintptr_t>(::operator new(sizeof(Record) + a - 1));
+                return new (reinterpret_cast<void *>((raw + a - 1) & ~std::uintptr_t(a - 1))) Record;
+            }
+
+            struct holder
+            {
+                holder()
+                : rec(acquire())
+                {}
+
+                ~holder()
+                {
+                    release(rec);
+                }
+
+                Record *rec;
+            };
+        };
+    }
+
+    namespace detail
+    {
+        /* global epoch counter shared by the epoch and quiescent based
+         * policies: records hold the epoch observed by the reader, 0 when
+         * the reader cannot hold any reference */
+
+        template <typename Tag>
+        struct epoch_domain
+        {
+            typedef uint64_t time_point;
+            typedef uint64_t duration;
+
+            static constexpr bool ordered = true;
+
+            /* stamp a retired node and move the global epoch forward */
+
+            static time_point
+            now()
+            {
+                return global().fetch_add(1, std::memory_order_seq_cst);
+            }
+
+            /* the oldest epoch observed by a reader */
+
+            static time_point
+            horizon()
+            {
+                asymmetric_fence::heavy();
+
+                time_point h = global().load(std::memory_order_relaxed);
+
+                registry::for_each([&](reader_record &r) {
+                    auto e = r.epoch.load(std::memory_order_acquire);
+                    if (e != 0 && e < h)
+                        h = e;
+                });
+
+                return h;
+            }
+
+            template <typename Node>
+            static bool
+            expired(Node const *p, time_point h)
+            {
+                return p->tp < h;
+            }
+
+        protected:
+
+            typedef reader_registry<Tag> registry;
+
+            static std::atomic<time_point> &
+            global()
+            {
+                static std::atomic<time_point> e(1);
+                return e;
+            }
+        };
+    }
+
+    struct EpochBased : detail::epoch_domain<EpochBased>
+    {
+        /* reader side: critical sections can be nested */
+
+        static void
+        enter()
+        {
+            auto &r = registry::local();
+            if (r.nesting++ == 0)
+            {
+                r.epoch.store(global().load(std::memory_order_acquire), std::memory_order_relaxed);
+                detail::asymmetric_fence::light();
+            }
+        }
+
+        static void
+        leave()
+        {
+            auto &r = registry::local();
+            if (--r.nesting == 0)
+                r.epoch.store(0, std::memory_order_release);
+        }
+
+        struct guard
+        {
+            guard()
+            {
+                EpochBased::enter();
+            }
+
+            ~guard()
+            {
+                EpochBased::leave();
+            }
+
+            guard(const guard &) = delete;
+            guard& operator=(const guard &) = delete;
+        };
+    };
+
+    /////////////////////// Quiescent State Based Reclamation:
+
+    struct Quiescent : detail::epoch_domain<Quiescent>
+    {
+        /* reader side: a registered (online) thread must periodically call
+         * quiescent() at a point where it holds no reference to any node;
+         * reads between two quiescent states add no cost */
+
+        static void
+        online()
+        {
+            auto &r = registry::local();
+            r.epoch.store(global().load(std::memory_order_acquire), std::memory_order_relaxed);
+            detail::asymmetric_fence::light();
+        }
+
+        static void
+        offline()
+        {
+            registry::local().epoch.store(0, std::memory_order_release);
+        }
+
+        static void
+        quiescent()
+        {
+            auto &r = registry::local();
+            if (r.epoch.load(std::memory_order_relaxed) != 0)
+                r.epoch.store(global().load(std::memory_order_acquire), std::memory_order_release);
+        }
+
+        struct registration
+        {
+            registration()
+            {
+                Quiescent::online();
+            }
+
+            ~registration()
+            {
+                Quiescent::offline();
+            }
+
+            registration(const registration &) = delete;
+            registration& operator=(const registration &) = delete;
+        };
+    };
+
+    /////////////////////// Hazard Pointers:
+
+    namespace detail
+    {
+        /* a hazard record protects up to two nodes: the one an iterator
+         * points at and the next one while hopping. Every hop stores into
+         * the slots: records sit on a cache line of their own */
+
+        struct alignas(64) hazard_record
+        {
+            std::atomic<void const *>   slot[2];
+            hazard_record *             next;
+            unsigned int                refs;
+            std::atomic<bool>           in_use;
+
+            void reset()
+            {
+                slot[0].store(nullptr, std::memory_order_release);
+                slot[1].store(nullptr, std::memory_order_release);
+                refs = 0;
+            }
+        };
+
+        /* reader-side hook of policies that do not protect iterators */
+
+        struct no_hazard
+        {
+            template <typename P>
+            P * protect(std::atomic<P *> const &src)
+            {
+                return src.load(std::memory_order_acquire);
+            }
+
+            template <typename P>
+            P * publish(P *p)
+            {
+                return p;
+            }
+        };
+
+        template <typename T>
+        struct always_void
+        {
+            typedef void type;
+        };
+
+        template <typename Policy, typename = void>
+        struct hazard_of
+        {
+            typedef no_hazard type;
+        };
+
+        template <typename Policy>
+        struct hazard_of<Policy, typename always_void<typename Policy::hazard>::type>
+        {
+            typedef typename Policy::hazard type;
+        };
+
+        /* per-container grace period, for the policies that have one */
+
+        template <typename Policy, typename = void>
+        struct grace_of
+        {
+            static constexpr bool timed = false;
+
+            template <typename Node, typename Horizon>
+            bool expired(Node const *p, Horizon &h) const
+            {
+                return Policy::expired(p, h);
+            }
+
+            template <typename Node, typename Horizon>
+            bool expired_now(Node const *p, Horizon &h) const
+            {
+                return Policy::expired(p, h);
+            }
+
+            void update()
+            { }
+
+            bool idle() const
+            {
+                return false;
+            }
+        };
+
+        template <typename Policy>
+        struct grace_of<Policy, typename always_void<decltype(Policy::grace_period())>::type>
+        {
+            typedef typename Policy::duration duration;
+
+            static constexpr bool timed = true;
+
+            grace_of()
+            : grace_(Policy::grace_period())
+            , adapt_(nullptr)
+            , open_(nullptr)
+            , idle_(nullptr)
+            {}
+
+            duration get() const
+            {
+                return grace_.load(std::memory_order_relaxed);
+            }
+
+            void set(std::chrono::nanoseconds d)
+            {
+                adapt_.store(nullptr, std::memory_order_relaxed);
+                open_.store(nullptr, std::memory_order_relaxed);
+                grace_.store(Policy::ticks(d), std::memory_order_relaxed);
+            }
+
+            /* the grace period is taken from fun() at every update; between
+             * updates open() tells how long the oldest reader still inside
+             * has been there */
+
+            void adapt(std::chrono::nanoseconds (*fun)(), std::chrono::nanoseconds (*open)())
+            {
+                adapt_.store(fun, std::memory_order_relaxed);
+                open_.store(open, std::memory_order_relaxed);
+                update();
+            }
+
+            void update()
+            {
+                if (auto fun = adapt_.load(std::memory_order_relaxed))
+                    grace_.store(Policy::ticks(fun()), std::memory_order_relaxed);
+            }
+
+            template <typename Node>
+            bool expired(Node const *p, typename Policy::time_point h) const
+            {
+                return Policy::expired(p, h, get());
+            }
+
+            /* away from the updates, the grace period may be older than a
+             * section opened since: the node must also outlast the oldest
+             * one still open. Only checked when the node is about to go */
+
+            template <typename Node>
+            bool expired_now(Node const *p, typename Policy::time_point h) const
+            {
+                if (!expired(p, h))
+                    return false;
+
+                auto open = open_.load(std::memory_order_relaxed);
+                return !open || Policy::expired(p, h, Policy::ticks(open()));
+            }
+
+            /* with no reader around the grace period can be skipped */
+
+            void track(bool (*fun)())
+            {
+                idle_.store(fun, std::memory_order_relaxed);
+            }
+
+            bool idle() const
+            {
+                auto fun = idle_.load(std::memory_order_relaxed);
+                return fun && fun();
+            }
+
+        private:
+            std::atomic<duration> grace_;
+            std::atomic<std::chrono::nanoseconds (*)()> adapt_;
+            std::atomic<std::chrono::nanoseconds (*)()> open_;
+            std::atomic<bool (*)()> idle_;
+        };
+    }
+
+    /* iterators protect the node they point at, however long they live;
+     * references returned by front() and back() are not protected */
+
+    struct HazardPointer
+    {
+        typedef uint64_t time_point;
+        typedef uint64_t duration;
+
+        static constexpr bool ordered = false;
+
+        static time_point
+        now()
+        {
+            return 0;
+        }
+
+        /* snapshot of the published hazards */
+
+        struct hazards
+        {
+            bool protects(void const *p) const
+            {
+                return std::binary_search(ptr.begin(), ptr.end(), p);
+            }
+
+            void add(void const *p)
+            {
+                auto it = std::lower_bound(ptr.begin(), ptr.end(), p);
+                if (it == ptr.end() || *it != p)
+                    ptr.insert(it, p);
+            }
+
+            std::vector<void const *> ptr;
+        };
+
+        static hazards
+        horizon()
+        {
+            hazards h;
+
+            detail::asymmetric_fence::heavy();
+
+            registry::for_each([&](detail::hazard_record &r) {
+                for(auto &s : r.slot)
+                {
+                    auto p = s.load(std::memory_order_acquire);
+                    if (p)
+                        h.ptr.push_back(p);
+                }
+            });
+
+            std::sort(h.ptr.begin(), h.ptr.end());
+            h.ptr.erase(std::unique(h.ptr.begin(), h.ptr.end()), h.ptr.end());
+            return h;
+        }
+
+        /* nodes are visited in retirement order: the next of a protected
+         * node, if retired, comes later and is protected in turn, since an
+         * iterator standing on a retired node can still step into it */
+
+        template <typename Node>
+        static bool
+        expired(Node const *p, hazards &h)
+        {
+            if (!h.protects(p))
+                return true;
+
+            auto n = p->next.load(std::memory_order_relaxed);
+            if (n)
+                h.add(n);
+            return false;
+        }
+
+        /* reader side: embedded in the iterators. Copies share the same
+         * record, which is detached as soon as one of them moves. */
+
+        struct hazard
+        {
+            hazard()
+            : rec_(nullptr)
+            , cur_(0)
+            {}
+
+            hazard(const hazard &other)
+            : rec_(other.rec_)
+            , cur_(other.cur_)
+            {
+                if (rec_)
+                    rec_->refs++;
+            }
+
+            hazard& operator=(const hazard &other)
+            {
+                if (rec_ != other.rec_)
+                {
+                    drop();
+                    rec_ = other.rec_;
+                    if (rec_)
+                        rec_->refs++;
+                }
+                cur_ = other.cur_;
+                return *this;
+            }
+
+            ~hazard()
+            {
+                drop();
+            }
+
+            template <typename P>
+            P * protect(std::atomic<P *> const &src)
+            {
+                auto p = src.load(std::memory_order_relaxed);
+                if (p == nullptr)
+                {
+                    drop();
+                    return nullptr;
+                }
+
+                auto old = rec_;
+                auto r = owned();
+                auto &s = r->slot[cur_ ^ 1];
+
+                for(;;)
+                {
+                    s.store(p, std::memory_order_relaxed);
+                    detail::asymmetric_fence::light();
+
+                    auto q = src.load(std::memory_order_acquire);
+                    if (q == p)
+                        break;
+
+                    if (q == nullptr)
+                    {
+                        if (old != r)
+                            release(old);
+                        drop();
+                        return nullptr;
+                    }
+                    p = q;
+                }
+
+                /* the previous node was protected until now */
+
+                if (old != r)
+                    release(old);
+
+                r->slot[cur_].store(nullptr, std::memory_order_release);
+                cur_ ^= 1;
+                return p;
+            }
+
+            /* protect a node the caller already knows to be safe */
+
+            template <typename P>
+            P * publish(P *p)
+            {
+                if (p == nullptr)
+                {
+                    drop();
+                    return nullptr;
+                }
+
+                auto old = rec_;
+                auto r = owned();
+
+                r->slot[cur_ ^ 1].store(p, std::memory_order_relaxed);
+                detail::asymmetric_fence::light();
+
+                if (old != r)
+                    release(old);
+
+                r->slot[cur_].store(nullptr, std::memory_order_release);
+                cur_ ^= 1;
+                return p;
+            }
+
+        private:
+
+            /* a record owned by this hazard only: the shared one, if any,
+             * stays referenced until the caller releases it */
+
+            detail::hazard_record *
+            owned()
+            {
+                if (rec_ && rec_->refs == 1)
+                    return rec_;
+
+                rec_ = cache::acquire();
+                rec_->refs = 1;
+                cur_ = 0;
+                return rec_;
+            }
+
+            static void
+            release(detail::hazard_record *r)
+            {
+                if (r && --r->refs == 0)
+                    cache::release(r);
+            }
+
+            void
+            drop()
+            {
+                release(rec_);
+                rec_ = nullptr;
+                cur_ = 0;
+            }
+
+            detail::hazard_record * rec_;
+            unsigned int cur_;
+        };
+
+    private:
+
+        typedef detail::reader_registry<HazardPointer, detail::hazard_record> registry;
+
+        /* per-thread cache of free records */
+
+        struct cache
+        {
+            enum : size_t { capacity = 16 };
+
+            ~cache()
+            {
+                for(size_t i = 0; i < size; i++)
+                    registry::release(rec[i]);
+            }
+
+            static detail::hazard_record *
+            acquire()
+            {
+                auto &c = local();
+                if (c.size)
+                    return c.rec[--c.size];
+                return registry::acquire();
+            }
+
+            static void
+            release(detail::hazard_record *r)
+            {
+                auto &c = local();
+                r->reset();
+                if (c.size < capacity)
+                    c.rec[c.size++] = r;
+                else
+                    registry::release(r);
+            }
+
+            static cache &
+            local()
+            {
+                static thread_local cache c;
+                return c;
+            }
+
+            detail::hazard_record * rec[capacity];
+            size_t size = 0;
+        };
+    };
+
+    /////////////////////// Adaptive grace period:
+    //
+    // Readers that wrap their traversals in a read_latency<Tag>::guard
+    // feed a per-thread histogram of the critical section lengths (log2
+    // bins of TSC ticks). A container made adaptive on the same Tag sets
+    // its grace period to a high percentile of the samples times a safety
+    // margin, refreshed at every scan of the garbage (a shrink, a
+    // reclaimer pass, every scan_threshold erases). It is only safe if all
+    // the readers of the container are sampled.
+    //
+    // A section is only binned when it ends: the outermost guard of each
+    // thread also publishes its start stamp, so that the grace period
+    // covers the longest section still open (a stalled reader) as well.
+    // Between scans, a node that the cached grace period would free on an
+    // erase or an insert is also checked against the oldest section still
+    // open, which may have started after the last refresh. The histograms keep accumulating until reset() or decay(), which
+    // let the percentile follow a change of workload.
+    //
+
+    namespace detail
+    {
+        /* written by the owner at every guard: the histogram and the
+         * section state sit on cache lines of their own */
+
+        struct alignas(64) latency_record
+        {
+            std::atomic<uint64_t>       bin[64];
+            alignas(64)
+            std::atomic<uint64_t>       start;      /* 0 outside any section */
+            unsigned int                depth;
+            latency_record *            next;
+            std::atomic<bool>           in_use;
+
+            void reset()
+            {
+                for(auto &b : bin)
+                    b.store(0, std::memory_order_relaxed);
+                start.store(0, std::memory_order_relaxed);
+                depth = 0;
+            }
+        };
+    }
+
+    template <typename Tag = void>
+    struct read_latency
+    {
+        typedef detail::reader_registry<read_latency, detail::latency_record> registry;
+
+        struct guard
+        {
+            guard()
+            : rec_(&registry::local())
+            , start_(TimeStampCounter::now())
+            {
+                if (rec_->depth++ == 0)
+                    rec_->start.store(start_, std::memory_order_relaxed);
+            }
+
+            ~guard()
+            {
+                auto now = TimeStampCounter::now();
+
+                if (--rec_->depth == 0)
+                    rec_->start.store(0, std::memory_order_relaxed);
+
+                add_(*rec_, now - start_);
+            }
+
+            guard(const guard &) = delete;
+            guard& operator=(const guard &) = delete;
+
+        private:
+            detail::latency_record * rec_;
+            TimeStampCounter::time_point start_;
+        };
+
+        /* the histogram is only written by the owner thread */
+
+        static void
+        sample(uint64_t ticks)
+        {
+            add_(registry::local(), ticks);
+        }
+
+        static uint64_t
+        samples()
+        {
+            uint64_t n = 0;
+            registry::for_each([&](detail::latency_record &r) {
+                for(auto &b : r.bin)
+                    n += b.load(std::memory_order_relaxed);
+            });
+            return n;
+        }
+
+        /* the longest section still open, in TSC ticks */
+
+        static uint64_t
+        open_section()
+        {
+            auto now = TimeStampCounter::now();
+            uint64_t ret = 0;
+
+            registry::for_each([&](detail::latency_record &r) {
+                auto s = r.start.load(std::memory_order_relaxed);
+                if (s && s < now)
+                    ret = std::max<uint64_t>(ret, now - s);
+            });
+            return ret;
+        }
+
+        /* drop the samples taken so far, or halve them. Called by any
+         * thread: a sample taken meanwhile may be lost, or survive the
+         * call */
+
+        static void
+        reset()
+        {
+            registry::for_each([](detail::latency_record &r) {
+                for(auto &b : r.bin)
+                    b.store(0, std::memory_order_relaxed);
+            });
+        }
+
+        static void
+        decay()
+        {
+            registry::for_each([](detail::latency_record &r) {
+                for(auto &b : r.bin)
+                    b.store(b.load(std::memory_order_relaxed) / 2, std::memory_order_relaxed);
+            });
+        }
+
+        /* upper bound of the q-th quantile in TSC ticks, 0 without samples */
+
+        static uint64_t
+        percentile(double q)
+        {
+            uint64_t hist[64] = {}, n = 0;
+
+            registry::for_each([&](detail::latency_record &r) {
+                for(size_t i = 0; i < 64; i++)
+                {
+                    auto c = r.bin[i].load(std::memory_order_relaxed);
+                    hist[i] += c;
+                    n += c;
+                }
+            });
+
+            if (n == 0)
+                return 0;
+
+            auto target = static_cast<uint64_t>(q * n);
+            uint64_t acc = 0;
+
+            for(size_t i = 0; i < 64; i++)
+            {
+                acc += hist[i];
+                if (acc > target || i == 63)
+                    return i == 63 ? std::numeric_limits<uint64_t>::max() : (1ULL << i);
+            }
+
+            return 0;
+        }
+
+        /* the grace period suggested by the samples and the sections still
+         * open, the default one if there are none */
+
+        static std::chrono::nanoseconds
+        grace_period()
+        {
+            auto t = std::max(percentile(defaults::read_percentile), open_section());
+            if (t == 0)
+                return defaults::grace_period;
+
+            return std::max(nanoseconds_(static_cast<long double>(t) * defaults::read_margin),
+                            std::chrono::nanoseconds(defaults::read_grace_floor));
+        }
+
+        /* how long the oldest section still open has lasted so far */
+
+        static std::chrono::nanoseconds
+        open_period()
+        {
+            return nanoseconds_(open_section());
+        }
+
+    private:
+
+        static std::chrono::nanoseconds
+        nanoseconds_(long double ticks)
+        {
+            auto ns = ticks * 1000000000 / TimeStampCounter::frequency();
+
+            if (ns > static_cast<long double>(std::chrono::nanoseconds::max().count()))
+                return std::chrono::nanoseconds::max();
+
+            return std::chrono::nanoseconds(static_cast<std::chrono::nanoseconds::rep>(ns));
+        }
+
+        static void
+        add_(detail::latency_record &r, uint64_t ticks)
+        {
+            auto &b = r.bin[bin_(ticks)];
+            b.store(b.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        }
+
+        /* bin i holds the samples in [2^(i-1), 2^i) */
+
+        static size_t
+        bin_(uint64_t ticks)
+        {
+            return ticks ? std::min<size_t>(63, 64 - __builtin_clzll(ticks)) : 0;
+        }
+    };
+
+    /////////////////////// Reader activity:
+    //
+    // Readers that wrap their traversals in a read_section<Tag>::guard
+    // flag their own cache line while inside. A container tracking the
+    // same Tag releases its garbage at once, regardless of the grace
+    // period, whenever a scan of the writer finds no reader inside (the
+    // check costs a membarrier, so it is not made on every erase): phases without
+    // readers (e.g. bulk reloads) do not pile up retired nodes. As with
+    // read_latency, all the readers of the container must use the guard.
+    //
+
+    namespace detail
+    {
+        struct alignas(64) section_record
+        {
+            std::atomic<unsigned int>   active;
+            section_record *            next;
+            std::atomic<bool>           in_use;
+
+            void reset()
+            {
+                active.store(0, std::memory_order_release);
+            }
+        };
+    }
+
+    template <typename Tag = void>
+    struct read_section
+    {
+        typedef detail::reader_registry<read_section, detail::section_record> registry;
+
+        /* sections can be nested; the flag is only written by the owner */
+
+        static void
+        enter()
+        {
+            auto &a = registry::local().active;
+            a.store(a.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+            detail::asymmetric_fence::light();
+        }
+
+        static void
+        leave()
+        {
+            auto &a = registry::local().active;
+            a.store(a.load(std::memory_order_relaxed) - 1, std::memory_order_release);
+        }
+
+        /* writer side: to be called after the nodes are unlinked */
+
+        static bool
+        idle()
+        {
+            detail::asymmetric_fence::heavy();
+
+            bool ret = true;
+            registry::for_each([&](detail::section_record &r) {
+                if (r.active.load(std::memory_order_acquire))
+                    ret = false;
+            });
+            return ret;
+        }
+
+        struct guard
+        {
+            guard()
+            {
+                read_section::enter();
+            }
+
+            ~guard()
+            {
+                read_section::leave();
+            }
+
+            guard(const guard &) = delete;
+            guard& operator=(const guard &) = delete;
+        };
+    };
+
+    /////////////////////// Slab allocation:
+    //
+    // Containers using a slab_allocator carve their nodes out of contiguous
+    // chunks of Chunk nodes, each node aligned to Align bytes (e.g. 64 for
+    // a cache line per node, 0 for the natural alignment). Destroyed nodes
+    // go back to the per-container free list instead of the allocator, and
+    // the chunks are released together once no node is in use. Anything
+    // else, such as the bucket array of a map, comes from std::allocator.
+    //
+
+    template <typename T, size_t Align = 0, size_t Chunk = defaults::slab_nodes>
+    struct slab_allocator : std::allocator<T>
+    {
+        static_assert((Align & (Align - 1)) == 0, "slab_allocator: Align must be a power of 2");
+        static_assert(Chunk > 0, "slab_allocator: empty chunks");
+
+        template <typename U>
+        struct rebind
+        {
+            typedef slab_allocator<U, Align, Chunk> other;
+        };
+
+        slab_allocator() noexcept
+        {}
+
+        template <typename U>
+        slab_allocator(slab_allocator<U, Align, Chunk> const &) noexcept
+        {}
+    };
+
+    namespace detail
+    {
+        template <typename Alloc>
+        struct slab_traits
+        {
+            static constexpr bool enabled = false;
+            static constexpr size_t align = 0;
+            static constexpr size_t chunk = 1;
+        };
+
+        template <typename T, size_t Align, size_t Chunk>
+        struct slab_traits<slab_allocator<T, Align, Chunk>>
+        {
+            static constexpr bool enabled = true;
+            static constexpr size_t align = Align;
+            static constexpr size_t chunk = Chunk;
+        };
+
+        /* whether the storage of destroyed nodes is kept in the pool of the
+         * container, for allocators that do not own it */
+
+        template <typename Alloc>
+        struct pool_traits
+        {
+            static constexpr bool enabled = true;
+        };
+    }
+
+    /////////////////////// Huge pages:
+    //
+    // A huge_page_allocator works as a slab_allocator whose chunks fill a
+    // huge page each; its large arrays (such as the bucket array of a map,
+    // from half a huge page up) are backed by huge pages as well, so that
+    // chain walks over big containers take fewer TLB misses. Pages come
+    // from the reserved pool (MAP_HUGETLB) if any, otherwise from a region
+    // aligned to the huge page size and advised with MADV_HUGEPAGE. Every
+    // container using it takes at least a huge page for its nodes.
+    //
+
+    namespace detail
+    {
+        inline size_t
+        huge_length(size_t bytes)
+        {
+            return (bytes + defaults::huge_page - 1) / defaults::huge_page * defaults::huge_page;
+        }
+
+        inline void *
+        huge_map(size_t bytes)
+        {
+            auto len = huge_length(bytes);
+#if defined(__linux__)
+            auto p = mmap(nullptr, len, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_HUGETLB, -1, 0);
+            if (p != MAP_FAILED)
+                return p;
+
+            auto q = mmap(nullptr, len + defaults::huge_page, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+            if (q == MAP_FAILED)
+                throw std::bad_alloc();
+
+            auto addr = reinterpret_cast<uintptr_t>(q);
+            auto lo = (addr + defaults::huge_page - 1) & ~(defaults::huge_page - 1);
+            auto hi = addr + len + defaults::huge_page;
+
+            if (lo > addr)
+                munmap(q, lo - addr);
+            if (hi > lo + len)
+                munmap(reinterpret_cast<void *>(lo + len), hi - lo - len);
+
+            madvise(reinterpret_cast<void *>(lo), len, MADV_HUGEPAGE);
+            return reinterpret_cast<void *>(lo);
+#else
+            return ::operator new(len);
+#endif
+        }
+
+        inline void
+        huge_unmap(void *p, size_t bytes)
+        {
+#if defined(__linux__)
+            munmap(p, huge_length(bytes));
+#else
+            (void)bytes;
+            ::operator delete(p);
+#endif
+        }
+    }
+
+    template <typename T, size_t Align = 0>
+    struct huge_page_allocator : std::allocator<T>
+    {
+        static_assert((Align & (Align - 1)) == 0, "huge_page_allocator: Align must be a power of 2");
+
+        template <typename U>
+        struct rebind
+        {
+            typedef huge_page_allocator<U, Align> other;
+        };
+
+        huge_page_allocator() noexcept
+        {}
+
+        template <typename U>
+        huge_page_allocator(huge_page_allocator<U, Align> const &) noexcept
+        {}
+
+        T * allocate(size_t n, const void * = nullptr)
+        {
+            if (n * sizeof(T) < defaults::huge_page / 2)
+                return std::allocator<T>::allocate(n);
+
+            return static_cast<T *>(detail::huge_map(n * sizeof(T)));
+        }
+
+        void deallocate(T *p, size_t n)
+        {
+            if (n * sizeof(T) < defaults::huge_page / 2)
+                std::allocator<T>::deallocate(p, n);
+            else
+                detail::huge_unmap(p, n * sizeof(T));
+        }
+    };
+
+    namespace detail
+    {
+        /* a chunk per huge page */
+
+        template <typename T, size_t Align>
+        struct slab_traits<huge_page_allocator<T, Align>>
+        {
+            static constexpr bool enabled = true;
+            static constexpr size_t align = Align;
+            static constexpr size_t chunk = 0;
+        };
+    }
+
+    /////////////////////// NUMA placement:
+    //
+    // The storage of a container can be bound to a NUMA node, so that the
+    // readers running there do not take remote misses: the bucket array of
+    // a map, and the slab chunks carved from then on (nodes allocated one
+    // by one are left where the allocator puts them). Only the pages fully
+    // covered by a region are bound, those already touched are migrated.
+    // Placement is a hint: failures (no NUMA support, no such node) are
+    // ignored.
+    //
+
+    namespace detail
+    {
+        inline bool
+        numa_bind(void const *addr, size_t len, int node)
+        {
+#if defined(__linux__)
+            if (node < 0)
+                return false;
+
+            auto page = static_cast<uintptr_t>(sysconf(_SC_PAGESIZE));
+            auto lo = (reinterpret_cast<uintptr_t>(addr) + page - 1) & ~(page - 1);
+            auto hi = (reinterpret_cast<uintptr_t>(addr) + len) & ~(page - 1);
+            if (hi <= lo)
+                return false;
+
+            const size_t bits = 8 * sizeof(unsigned long);
+
+            std::vector<unsigned long> mask(node / bits + 1);
+            mask[node / bits] |= 1UL << (node % bits);
+
+            return syscall(__NR_mbind, lo, hi - lo, MPOL_PREFERRED, mask.data(),
+                           mask.size() * bits + 1, MPOL_MF_MOVE) == 0;
+#else
+            (void)addr; (void)len; (void)node;
+            return false;
+#endif
+        }
+    }
+
+    /////////////////////// Garbage watermarks:
+    //
+    // Bounds on the retired nodes a container has not reclaimed yet, by
+    // count and by bytes of node storage (a zero high watermark disables
+    // the bound). Crossing the high watermark makes the writer flush the
+    // garbage in bulk and, if that is not enough, keep flushing for up to
+    // wait. on_high is called once when the pressure starts, on_low once
+    // the garbage is back under the low watermark, both in the writer
+    // thread.
+    //
+
+    struct watermarks
+    {
+        size_t high_nodes = 0;
+        size_t low_nodes  = 0;
+        size_t high_bytes = 0;
+        size_t low_bytes  = 0;
+
+        std::chrono::microseconds wait {0};
+
+        std::function<void(size_t nodes, size_t bytes)> on_high;
+        std::function<void(size_t nodes, size_t bytes)> on_low;
+    };
+
+    ///////////////////// Reclamation domain
+    //
+    // Node storage and retirement shared by the nodes of one or more lists:
+    // a shared_list owns a domain, the buckets of a shared_unordered_map
+    // share a single one.
+    //
+
+    namespace detail
+    {
+        /* readers only touch next and value: they come first, so that a hop
+         * (and the key of a map entry) takes a single cache line, while the
+         * fields used by the writer and the reclamation trail */
+
+        template <typename T, typename Time>
+        struct shared_node
+        {
+            std::atomic<shared_node *>              next;
+            T                                       value;
+            typename Time::time_point               tp;
+            shared_node *                           prev;
+        };
+
+        template <typename T, typename Time, typename Alloc>
+        struct shared_domain
+        {
+            typedef shared_node<T, Time>                          node;
+            typedef typename Alloc::template rebind<node>::other  AllocNode;
+
+            explicit shared_domain(const Alloc &alloc = Alloc())
+            : alloc_(alloc)
+            , pool_(alloc)
+            , reclaimer_(nullptr)
+            , busy_(false)
+            , grace_()
+            , marks_()
+            , pressure_on_(false)
+            , disposer_(nullptr)
+            , dead_(nullptr)
+            , dead_size_(0)
+            , deferred_()
+            , deferred_size_(0)
+            , garbage_(this)
+            {}
+
+            /* the deferred callbacks still pending are run before returning */
+
+            ~shared_domain()
+            {
+                this->detach();
+
+                while (deferred_size_.load(std::memory_order_relaxed))
+                {
+                    garbage_.flush();
+                    run_deferred_();
+                    if (deferred_size_.load(std::memory_order_relaxed))
+                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+            }
+
+            shared_domain(const shared_domain &) = delete;
+            shared_domain& operator=(const shared_domain &) = delete;
+
+            /* the attachment of rhs stays behind: its disposer is drained
+             * and its reclaimer held off while the state is taken */
+
+            shared_domain(shared_domain &&rhs)
+            : shared_domain(rhs.alloc_)
+            {
+                rhs.drain_();
+                reclaim_guard other_lock(&rhs);
+
+                pool_ = std::move(rhs.pool_);
+
+                garbage_ = std::move(rhs.garbage_);
+                garbage_.set_ownership(this);
+
+                deferred_.swap(rhs.deferred_);
+                deferred_size_.store(deferred_.size(), std::memory_order_relaxed);
+                rhs.deferred_size_.store(0, std::memory_order_relaxed);
+            }
+
+            shared_domain& operator=(shared_domain &&rhs)
+            {
+                if (&rhs != this)
+                {
+                    rhs.drain_();
+                    reclaim_guard other_lock(&rhs);
+
+                    /* nodes are returned to the allocator they come from */
+
+                    garbage_ = std::move(rhs.garbage_);
+                    garbage_.set_ownership(this);
+
+                    drain_();
+
+                    /* callbacks follow the nodes they were deferred after */
+
+                    for(auto &d : rhs.deferred_)
+                        deferred_.push_back(std::move(d));
+                    rhs.deferred_.clear();
+                    rhs.deferred_size_.store(0, std::memory_order_relaxed);
+                    deferred_size_.store(deferred_.size(), std::memory_order_relaxed);
+
+                    alloc_ = rhs.alloc_;
+                    pool_  = std::move(rhs.pool_);
+                }
+                return *this;
+            }
+
+            /* attachment, grace period and watermarks are not transferred by
+             * move or swap */
+
+            void swap(shared_domain &other)
+            {
+                drain_();
+                other.drain_();
+
+                reclaim_guard lock(this), other_lock(&other);
+
+                std::swap(alloc_, other.alloc_);
+                pool_.swap(other.pool_);
+                garbage_.swap(other.garbage_);
+
+                deferred_.swap(other.deferred_);
+                deferred_size_.store(deferred_.size(), std::memory_order_relaxed);
+                other.deferred_size_.store(other.deferred_.size(), std::memory_order_relaxed);
+            }
+
+            template <typename ...Ts>
+            node * new_node(Ts && ...args)
+            {
+                node * p = alloc_node_();
+                p->tp = typename Time::time_point();
+                try
+                {
+                    alloc_.construct(&p->value, std::forward<Ts>(args)...);
+                }
+                catch(...)
+                {
+                    dealloc_node_(p);
+                    throw;
+                }
+                return p;
+            }
+
+            /* thread-safe: neither the pool nor the garbage is touched, the
+             * node comes straight from the allocator */
+
+            template <typename ...Ts>
+            node * new_concurrent_node(Ts && ...args)
+            {
+                Alloc alloc(alloc_);
+                AllocNode alloc_node(alloc_);
+
+                node * p = alloc_node.allocate(1);
+                p->tp = typename Time::time_point();
+                try
+                {
+                    alloc.construct(&p->value, std::forward<Ts>(args)...);
+                }
+                catch(...)
+                {
+                    alloc_node.deallocate(p, 1);
+                    throw;
+                }
+                return p;
+            }
+
+            /* the node must be already unlinked. Without the reserve, all
+             * the expired nodes are freed at once, none being kept back
+             * for the next insert (e.g. when nodes are not allocated here) */
+
+            void retire(node *p, bool reserve = true)
+            {
+                garbage_.free(p, reserve);
+                if (marks_)
+                    pressure_();
+                if (deferred_size_.load(std::memory_order_relaxed))
+                    run_deferred_();
+            }
+
+            /* n unlinked nodes, linked through prev from front to back with
+             * back->prev == nullptr, are retired with a single stamp. They
+             * must come in list order (the next of a node after it), as
+             * the hazard pointer scan extends protection forward */
+
+            void retire_chain(node *front, node *back, size_t n)
+            {
+                if (n == 0)
+                    return;
+
+                garbage_.free_chain(front, back, n);
+                if (marks_)
+                    pressure_();
+                if (deferred_size_.load(std::memory_order_relaxed))
+                    run_deferred_();
+            }
+
+            /* thread unsafe: with no readers around, nodes are destroyed at
+             * once and go straight back to the allocator (or the slab),
+             * bypassing the pool. Disjoint chains can be destroyed
+             * concurrently */
+
+            void destroy_list(node *p) const
+            {
+                Alloc alloc(alloc_);
+                AllocNode alloc_node(alloc_);
+
+                node *q;
+                for(; p != nullptr; p = q)
+                {
+                    q = p->next.load(std::memory_order_relaxed);
+                    alloc.destroy(&p->value);
+                    if (node_pool::slab::enabled)
+                        pool_.give_back(p);
+                    else
+                        alloc_node.deallocate(p, 1);
+                }
+            }
+
+            /* thread unsafe, with no readers around: the chains (linked
+             * through next) and the retired nodes are destroyed by the
+             * threads of the attached disposer, in up to the given number
+             * of batches, and deferred callbacks are run. Returns without
+             * waiting for the disposer; a batch it refuses is destroyed
+             * here. The n nodes of the chains are for its statistics */
+
+            void hand_over(std::vector<node *> chains, size_t batches, size_t n)
+            {
+                batches = std::max<size_t>(1, std::min(batches, chains.size()));
+
+                for(size_t b = 0; b < batches && !chains.empty(); b++)
+                {
+                    auto first = chains.size() * b / batches;
+                    auto last  = chains.size() * (b + 1) / batches;
+
+                    std::unique_ptr<std::vector<node *>> batch(new std::vector<node *>(chains.begin() + first, chains.begin() + last));
+
+                    auto nodes = n * last / chains.size() - n * first / chains.size();
+
+                    if (disposer_ && disposer_->post(&dispose_chains_, this, batch.get(), nodes))
+                        batch.release();
+                    else
+                        dispose_chains_(this, batch.release());
+                }
+
+                std::deque<deferred> ready;
+                {
+                    reclaim_guard lock(this);
+                    garbage_.purge_();
+                    if (disposer_)
+                        post_();
+                    ready.swap(deferred_);
+                    deferred_size_.store(0, std::memory_order_relaxed);
+                }
+
+                for(auto &d : ready)
+                    d.second();
+            }
+
+            /* thread unsafe: free the retired nodes and run the deferred
+             * callbacks regardless of the grace period, and release the
+             * pooled storage */
+
+            size_t purge()
+            {
+                size_t n;
+                std::deque<deferred> ready;
+                {
+                    reclaim_guard lock(this);
+                    n = garbage_.purge_();
+                    ready.swap(deferred_);
+                    deferred_size_.store(0, std::memory_order_relaxed);
+                }
+                drain_();
+                {
+                    reclaim_guard lock(this);
+                    pool_.release();
+                }
+
+                for(auto &d : ready)
+                    d.second();
+                return n;
+            }
+
+            std::ptrdiff_t flush(size_t budget = std::numeric_limits<size_t>::max())
+            {
+                auto n = garbage_.flush(budget);
+                if (marks_)
+                    pressure_();
+                if (deferred_size_.load(std::memory_order_relaxed))
+                    run_deferred_();
+                return n;
+            }
+
+            /* to be called by the writer: returns once the readers that could
+             * have seen a node retired before the call are gone. With the
+             * epoch policies the caller must not be a reader itself */
+
+            void synchronize()
+            {
+                token t;
+                {
+                    reclaim_guard lock(this);
+                    t = start_(std::integral_constant<bool, Time::ordered>());
+                }
+
+                for(unsigned int i = 0;; i++)
+                {
+                    {
+                        reclaim_guard lock(this);
+                        if (!Time::ordered)
+                            garbage_.flush_();
+                        if (elapsed_(t))
+                            break;
+                    }
+
+                    if (i < 64)
+                        std::this_thread::yield();
+                    else
+                        std::this_thread::sleep_for(std::chrono::microseconds(100));
+                }
+            }
+
+            /* fun is called after the same grace period, by the writer at a
+             * later retire or shrink, or by the reclaimer thread: it must not
+             * throw */
+
+            void defer(std::function<void()> fun)
+            {
+                reclaim_guard lock(this);
+                deferred_.emplace_back(start_(std::integral_constant<bool, Time::ordered>()), std::move(fun));
+                deferred_size_.store(deferred_.size(), std::memory_order_relaxed);
+            }
+
+            /* to be called by the writer */
+
+            void set_watermarks(watermarks const &w)
+            {
+                marks_.reset((w.high_nodes || w.high_bytes) ? new watermarks(w) : nullptr);
+                pressure_on_ = false;
+            }
+
+            size_t garbage_size() const
+            {
+                return garbage_.size();
+            }
+
+            size_t garbage_bytes() const
+            {
+                return garbage_.size() * sizeof(node);
+            }
+
+            void attach(reclaimer &r)
+            {
+                if (reclaimer_)
+                    reclaimer_->detach(this);
+                r.attach(this, [this](size_t budget) { return this->reclaim_(budget); });
+                reclaimer_ = &r;
+            }
+
+            /* expired nodes are destroyed by the disposer threads: the
+             * allocator must be thread-safe */
+
+            void attach(disposer &d)
+            {
+                drain_();
+                reclaim_guard lock(this);
+                disposer_ = &d;
+            }
+
+            /* detach from both the reclaimer and the disposer, waiting for
+             * the nodes already handed over */
+
+            void detach()
+            {
+                if (reclaimer_)
+                {
+                    reclaimer_->detach(this);
+                    reclaimer_ = nullptr;
+                }
+
+                if (disposer_)
+                {
+                    drain_();
+                    disposer_ = nullptr;
+                }
+            }
+
+            bool attached() const noexcept
+            {
+                return reclaimer_ != nullptr || disposer_ != nullptr;
+            }
+
+            bool disposing() const noexcept
+            {
+                return disposer_ != nullptr;
+            }
+
+            /* time policies only: can be changed while readers are around */
+
+            typename Time::duration grace_period() const
+            {
+                return grace_.get();
+            }
+
+            void grace_period(std::chrono::nanoseconds d)
+            {
+                grace_.set(d);
+            }
+
+            template <typename Tag>
+            void adapt_grace_period()
+            {
+                grace_.adapt(&read_latency<Tag>::grace_period, &read_latency<Tag>::open_period);
+            }
+
+            template <typename Tag>
+            void track_readers()
+            {
+                grace_.track(&read_section<Tag>::idle);
+            }
+
+            /* to be called by the writer: slab chunks only */
+
+            void numa_node(int n)
+            {
+                reclaim_guard lock(this);
+                pool_.numa_node(n);
+            }
+
+            int numa_node() const
+            {
+                return pool_.numa_node();
+            }
+
+            Alloc get_allocator() const noexcept
+            {
+                return alloc_;
+            }
+
+            size_t max_size() const noexcept
+            {
+                return alloc_.max_size();
+            }
+
+        private:
+
+            /* expired nodes are reused before asking the allocator */
+
+            node * alloc_node_()
+            {
+                reclaim_guard lock(this);
+
+                /* with a disposer the values are destroyed by its threads:
+                 * expired nodes are not recycled here */
+
+                auto p = disposer_ ? nullptr : garbage_.recycle();
+                if (p)
+                {
+                    alloc_.destroy(&p->value);
+                    return p;
+                }
+                return pool_.allocate();
+            }
+
+            void dealloc_node_(node *p)
+            {
+                reclaim_guard lock(this);
+                pool_.deallocate(p);
+            }
+
+            void destroy_node_(node *n)
+            {
+                if (disposer_)
+                {
+                    n->prev = dead_;
+                    dead_ = n;
+                    if (++dead_size_ >= defaults::dispose_batch)
+                        post_();
+                    return;
+                }
+
+                alloc_.destroy(&n->value);
+                pool_.deallocate(n);
+            }
+
+            /* hand the collected nodes over to the disposer, or destroy them
+             * here if its queue is full */
+
+            void post_()
+            {
+                if (dead_ == nullptr)
+                    return;
+
+                if (!disposer_->post(&dispose_, this, dead_, dead_size_))
+                    dispose_(this, dead_);
+
+                dead_ = nullptr;
+                dead_size_ = 0;
+            }
+
+            void drain_()
+            {
+                if (disposer_)
+                {
+                    {
+                        reclaim_guard lock(this);
+                        post_();
+                    }
+                    disposer_->wait();
+                }
+            }
+
+            /* disposer side: whole chains handed over by hand_over() */
+
+            static void
+            dispose_chains_(void *ctx, void *batch)
+            {
+                auto dom = static_cast<shared_domain *>(ctx);
+                std::unique_ptr<std::vector<node *>> chains(static_cast<std::vector<node *> *>(batch));
+
+                for(auto p : *chains)
+                    dom->destroy_list(p);
+            }
+
+            /* disposer side: nodes go straight back to the allocator */
+
+            static void
+            dispose_(void *ctx, void *batch)
+            {
+                auto dom = static_cast<shared_domain *>(ctx);
+
+                Alloc alloc(dom->alloc_);
+                AllocNode alloc_node(dom->alloc_);
+
+                node *q;
+                for(auto p = static_cast<node *>(batch); p != nullptr; p = q)
+                {
+                    q = p->prev;
+                    alloc.destroy(&p->value);
+                    if (node_pool::slab::enabled)
+                        dom->pool_.give_back(p);
+                    else
+                        alloc_node.deallocate(p, 1);
+                }
+            }
+
+            /* garbage and node pool are shared with the reclaimer thread, if
+             * attached: writer and reclaimer serialize on a spinlock */
+
+            struct reclaim_guard
+            {
+                explicit reclaim_guard(shared_domain *d)
+                : dom_(d && d->reclaimer_ ? d : nullptr)
+                {
+                    if (dom_)
+                    {
+                        while (dom_->busy_.exchange(true, std::memory_order_acquire))
+                            std::this_thread::yield();
+                    }
+                }
+
+                ~reclaim_guard()
+                {
+                    if (dom_)
+                        dom_->busy_.store(false, std::memory_order_release);
+                }
+
+                reclaim_guard(const reclaim_guard &) = delete;
+                reclaim_guard& operator=(const reclaim_guard &) = delete;
+
+            private:
+                shared_domain *dom_;
+            };
+
+            bool above_(size_t nodes, size_t bytes) const
+            {
+                return (nodes && garbage_size() > nodes) || (bytes && garbage_bytes() > bytes);
+            }
+
+            bool below_low_() const
+            {
+                return (!marks_->high_nodes || garbage_size() <= marks_->low_nodes) &&
+                       (!marks_->high_bytes || garbage_bytes() <= marks_->low_bytes);
+            }
+
+            /* writer side: flush in bulk when the high watermark is crossed,
+             * for up to marks_->wait if that is not enough */
+
+            void pressure_()
+            {
+                if (!pressure_on_)
+                {
+                    if (!above_(marks_->high_nodes, marks_->high_bytes))
+                        return;
+
+                    pressure_on_ = true;
+                    if (marks_->on_high)
+                        marks_->on_high(garbage_size(), garbage_bytes());
+                }
+
+                if (above_(marks_->high_nodes, marks_->high_bytes))
+                {
+                    garbage_.flush();
+
+                    auto deadline = std::chrono::steady_clock::now() + marks_->wait;
+                    while (above_(marks_->high_nodes, marks_->high_bytes) &&
+                           std::chrono::steady_clock::now() < deadline)
+                    {
+                        std::this_thread::yield();
+                        garbage_.flush();
+                    }
+                }
+
+                if (below_low_())
+                {
+                    pressure_on_ = false;
+                    if (marks_->on_low)
+                        marks_->on_low(garbage_size(), garbage_bytes());
+                }
+            }
+
+            size_t reclaim_(size_t budget)
+            {
+                if (busy_.exchange(true, std::memory_order_acquire))
+                    return 0;
+
+                auto n = garbage_.flush_(budget);
+
+                std::vector<std::function<void()>> ready;
+                if (deferred_size_.load(std::memory_order_relaxed))
+                    take_deferred_(ready);
+
+                busy_.store(false, std::memory_order_release);
+
+                for(auto &f : ready)
+                    f();
+                return n < 0 ? 0 : n;
+            }
+
+            /* a grace period is a stamp for the ordered policies, and the set
+             * of nodes retired so far for the others: it has elapsed once
+             * they are all reclaimed */
+
+            struct stamp
+            {
+                typename Time::time_point tp;
+            };
+
+            typedef typename std::conditional<Time::ordered, stamp, std::vector<node const *>>::type token;
+            typedef std::pair<token, std::function<void()>> deferred;
+
+            stamp start_(std::true_type)
+            {
+                return stamp{Time::now()};
+            }
+
+            std::vector<node const *> start_(std::false_type) const
+            {
+                std::vector<node const *> v;
+                garbage_.collect(v);
+                std::sort(v.begin(), v.end());
+                return v;
+            }
+
+            bool elapsed_(stamp const &s) const
+            {
+                auto h = Time::horizon();
+                return grace_.expired_now(&s, h) || grace_.idle();
+            }
+
+            bool elapsed_(std::vector<node const *> const &v) const
+            {
+                return !garbage_.retains(v);
+            }
+
+            /* callbacks are run outside the lock */
+
+            void run_deferred_()
+            {
+                std::vector<std::function<void()>> ready;
+                {
+                    reclaim_guard lock(this);
+                    take_deferred_(ready);
+                }
+
+                for(auto &f : ready)
+                    f();
+            }
+
+            void take_deferred_(std::vector<std::function<void()>> &ready)
+            {
+                for(auto it = deferred_.begin(); it != deferred_.end();)
+                {
+                    if (elapsed_(it->first))
+                    {
+                        ready.push_back(std::move(it->second));
+                        it = deferred_.erase(it);
+                    }
+                    else if (Time::ordered)
+                        break;
+                    else
+                        ++it;
+                }
+
+                deferred_size_.store(deferred_.size(), std::memory_order_relaxed);
+            }
+
+
+            struct garbage
+            {
+                garbage(shared_domain *d)
+                : owner_(d)
+                , ptr_(nullptr)
+                , tail_(nullptr)
+                , pending_(0)
+                , size_(0)
+                , horizon_cache_()
+                , checks_(0)
+                {}
+
+                ~garbage()
+                {
+                    while(this->flush() != -1)
+                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+                }
+
+                garbage(const garbage &) = delete;
+                garbage& operator=(const garbage &) = delete;
+
+                garbage(garbage &&other)
+                : size_(other.size())
+                , horizon_cache_()
+                , checks_(0)
+                {
+                    ptr_  = other.ptr_, other.ptr_ = nullptr;
+                    tail_ = other.tail_, other.tail_ = nullptr;
+                    pending_ = other.pending_, other.pending_ = 0;
+                    other.size_.store(0, std::memory_order_relaxed);
+                    owner_ = nullptr;
+                }
+
+                garbage& operator=(garbage &&other)
+                {
+                    while(this->flush() != -1)
+                        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+                    ptr_ = other.ptr_, other.ptr_ = nullptr;
+                    tail_ = other.tail_, other.tail_ = nullptr;
+                    pending_ = other.pending_, other.pending_ = 0;
+                    size_.store(other.size(), std::memory_order_relaxed);
+                    other.size_.store(0, std::memory_order_relaxed);
+                    owner_ = nullptr;
+                    return *this;
+                }
+
+                void
+                set_ownership(shared_domain *d)
+                {
+                    owner_ = d;
+                }
+
+                void
+                swap(garbage &other)
+                {
+                    std::swap(ptr_, other.ptr_);
+                    std::swap(tail_, other.tail_);
+                    std::swap(pending_, other.pending_);
+
+                    auto n = size();
+                    size_.store(other.size(), std::memory_order_relaxed);
+                    other.size_.store(n, std::memory_order_relaxed);
+                }
+
+                /* retired nodes not yet reclaimed, readable by any thread */
+
+                size_t
+                size() const
+                {
+                    return size_.load(std::memory_order_relaxed);
+                }
+
+
+                void free(node *p, bool reserve = true)
+                {
+                    reclaim_guard lock(owner_);
+
+                    p->tp    = Time::now();
+                    p->prev  = nullptr;
+
+                    if (tail_)
+                    {
+                        tail_->prev = p;
+                    }
+                    else
+                    {
+                        ptr_ = p;
+                    }
+
+                    tail_ = p;
+                    count_(1);
+
+                    /* the idle check and the hazard scan go by batches */
+
+                    if (++pending_ >= defaults::scan_threshold)
+                    {
+                        pending_ = 0;
+                        flush_();
+                    }
+                    else if (Time::ordered && !reserve)
+                    {
+                        auto h = horizon_();
+                        while (ptr_ != tail_ && owner_->grace_.expired_now(ptr_, h))
+                        {
+                            auto q = ptr_;
+                            ptr_ = q->prev;
+                            inherit_(q, ptr_);
+                            count_(-1);
+                            owner_->destroy_node_(q);
+                        }
+                    }
+                    else if (Time::ordered)
+                    {
+                        /* the oldest expired node is kept for recycle() */
+
+                        auto n = ptr_->prev;
+                        if (n)
+                        {
+                            inherit_(ptr_, n);
+
+                            auto h = horizon_();
+                            if (owner_->grace_.expired_now(n, h))
+                            {
+                                auto q = ptr_;
+                                ptr_ = n;
+                                count_(-1);
+                                owner_->destroy_node_(q);
+                            }
+                        }
+                    }
+                }
+
+
+                /* a chain of n nodes linked through prev, from front to back
+                 * (back->prev == nullptr), is queued at once with a single
+                 * stamp: the others still carry the null time_point of a
+                 * fresh node and inherit it when they reach the front */
+
+                void free_chain(node *front, node *back, size_t n)
+                {
+                    reclaim_guard lock(owner_);
+
+                    front->tp = Time::now();
+
+                    if (tail_)
+                    {
+                        tail_->prev = front;
+                    }
+                    else
+                    {
+                        ptr_ = front;
+                    }
+
+                    tail_ = back;
+                    count_(n);
+
+                    if (owner_->grace_.idle())
+                    {
+                        release_();
+                    }
+                    else if (!Time::ordered && (pending_ += n) >= defaults::scan_threshold)
+                    {
+                        pending_ = 0;
+                        flush_();
+                    }
+                }
+
+                /* take back the oldest expired node, if any */
+
+                node *
+                recycle()
+                {
+                    auto p = ptr_;
+                    if (p == nullptr || !Time::ordered)
+                        return nullptr;
+
+                    auto h = horizon_();
+                    if (owner_->grace_.expired_now(p, h))
+                    {
+                        ptr_ = ptr_->prev;
+                        if (ptr_ == nullptr)
+                            tail_ = nullptr;
+                        else
+                            inherit_(p, ptr_);
+                        count_(-1);
+                        return p;
+                    }
+                    return nullptr;
+                }
+
+                std::ptrdiff_t
+                flush(size_t budget = std::numeric_limits<size_t>::max())
+                {
+                    reclaim_guard lock(owner_);
+                    return flush_(budget);
+                }
+
+                std::ptrdiff_t
+                flush_(size_t budget = std::numeric_limits<size_t>::max())
+                {
+                    node *q = nullptr, *p = ptr_, *n;
+
+                    owner_->grace_.update();
+
+                    if (p == nullptr)
+                        return -1;
+
+                    auto h = Time::horizon();
+                    auto idle = owner_->grace_.idle();
+
+                    cache_(h, cached());
+
+                    size_t ret = 0;
+
+                    for(; p != nullptr && ret < budget; p = n)
+                    {
+                        n = p->prev;
+                        if (n)
+                            inherit_(p, n);
+
+                        if (idle || owner_->grace_.expired(p, h))
+                        {
+                            if (q)
+                                q->prev = n;
+                            else
+                                ptr_ = n;
+
+                            if (p == tail_)
+                                tail_ = q;
+
+                            ret++;
+                            owner_->destroy_node_(p);
+                        }
+                        else if (Time::ordered)
+                            break;
+                        else
+                            q = p;
+                    }
+
+                    if (ptr_ == nullptr)
+                        tail_ = nullptr;
+
+                    count_(-static_cast<std::ptrdiff_t>(ret));
+
+                    if (owner_->disposer_)
+                        owner_->post_();
+
+                    return ret;
+                }
+
+                /* the nodes still retired, oldest first */
+
+                void
+                collect(std::vector<node const *> &v) const
+                {
+                    for(auto p = ptr_; p != nullptr; p = p->prev)
+                        v.push_back(p);
+                }
+
+                /* whether any of the sorted nodes is still retired */
+
+                bool
+                retains(std::vector<node const *> const &v) const
+                {
+                    if (v.empty())
+                        return false;
+
+                    for(auto p = ptr_; p != nullptr; p = p->prev)
+                    {
+                        if (std::binary_search(v.begin(), v.end(), p))
+                            return true;
+                    }
+                    return false;
+                }
+
+                size_t
+                purge_()
+                {
+                    node *n;
+                    size_t ret = 0;
+
+                    for(auto p = ptr_; p != nullptr; p = n, ret++)
+                    {
+                        n = p->prev;
+                        owner_->destroy_node_(p);
+                    }
+
+                    ptr_ = tail_ = nullptr;
+                    pending_ = 0;
+                    size_.store(0, std::memory_order_relaxed);
+                    return ret;
+                }
+
+            private:
+
+                /* free() and recycle() run on every writer operation: with
+                 * the epoch policies they compare against the horizon of
+                 * the last scan, taken anew every scan_threshold checks,
+                 * as horizon() serializes every CPU of the process. An old
+                 * horizon only delays reclamation. The clock of the time
+                 * policies is read every time */
+
+                typedef decltype(Time::horizon()) horizon_type;
+                typedef std::integral_constant<bool, Time::ordered && !grace_of<Time>::timed> cached;
+
+                horizon_type
+                horizon_()
+                {
+                    return horizon_(cached());
+                }
+
+                horizon_type
+                horizon_(std::false_type)
+                {
+                    return Time::horizon();
+                }
+
+                horizon_type
+                horizon_(std::true_type)
+                {
+                    if (++checks_ >= defaults::scan_threshold)
+                        cache_(Time::horizon(), cached());
+                    return horizon_cache_;
+                }
+
+                void
+                cache_(horizon_type const &h, std::true_type)
+                {
+                    horizon_cache_ = h;
+                    checks_ = 0;
+                }
+
+                void
+                cache_(horizon_type const &, std::false_type)
+                { }
+
+                /* no reader inside: the whole garbage goes */
+
+                void
+                release_()
+                {
+                    purge_();
+                    if (owner_->disposer_)
+                        owner_->post_();
+                }
+
+                static void
+                inherit_(node const *p, node *n)
+                {
+                    if (n->tp == typename Time::time_point())
+                        n->tp = p->tp;
+                }
+
+                /* updates are serialized by the reclaim_guard */
+
+                void
+                count_(std::ptrdiff_t n)
+                {
+                    size_.store(size_.load(std::memory_order_relaxed) + n, std::memory_order_relaxed);
+                }
+
+                shared_domain * owner_;
+                node * ptr_;
+                node * tail_;
+                size_t pending_;
+                std::atomic<size_t> size_;
+
+                horizon_type horizon_cache_;
+                size_t checks_;
+            };
+
+            /* per-container pool of node storage: destroyed nodes are kept for
+             * the next insert, the excess goes back to the node allocator.
+             * With a slab_allocator all of them are kept, and the storage is
+             * carved from chunks that are released as a whole */
+
+            struct node_pool
+            {
+                typedef slab_traits<Alloc> slab;
+                typedef typename Alloc::template rebind<char>::other AllocChunk;
+
+                static constexpr size_t align  = slab::align > alignof(node) ? slab::align : alignof(node);
+                static constexpr size_t stride = (sizeof(node) + align - 1) / align * align;
+                static constexpr size_t chunk  = slab::chunk ? slab::chunk : (defaults::huge_page - align + 1) / stride;
+                static constexpr size_t bytes  = chunk * stride + align - 1;
+
+                explicit node_pool(AllocNode const &alloc)
+                : alloc_(alloc)
+                , free_(nullptr)
+                , size_(0)
+                , returned_(nullptr)
+                , chunks_()
+                , cur_(nullptr)
+                , end_(nullptr)
+                , carved_(0)
+                , numa_(-1)
+                {}
+
+                ~node_pool()
+                {
+                    release();
+                    free_chunks_();
+                }
+
+                node_pool(const node_pool &) = delete;
+                node_pool& operator=(const node_pool &) = delete;
+
+                node_pool(node_pool &&other)
+                : alloc_(other.alloc_)
+                , free_(other.free_)
+                , size_(other.size_)
+                , returned_(other.returned_.exchange(nullptr, std::memory_order_acquire))
+                , chunks_(std::move(other.chunks_))
+                , cur_(other.cur_)
+                , end_(other.end_)
+                , carved_(other.carved_)
+                , numa_(-1)
+                {
+                    other.free_ = nullptr;
+                    other.size_ = 0;
+                    other.chunks_.clear();
+                    other.cur_ = other.end_ = nullptr;
+                    other.carved_ = 0;
+                }
+
+                /* the nodes carved from the chunks released here must be all
+                 * destroyed by now */
+
+                node_pool& operator=(node_pool &&other)
+                {
+                    if (&other != this)
+                    {
+                        release();
+                        free_chunks_();
+                        alloc_ = other.alloc_;
+                        free_  = other.free_, other.free_ = nullptr;
+                        size_  = other.size_, other.size_ = 0;
+                        returned_.store(other.returned_.exchange(nullptr, std::memory_order_acquire), std::memory_order_relaxed);
+                        chunks_.swap(other.chunks_);
+                        cur_ = other.cur_, other.cur_ = nullptr;
+                        end_ = other.end_, other.end_ = nullptr;
+                        carved_ = other.carved_, other.carved_ = 0;
+                    }
+                    return *this;
+                }
+
+                void
+                swap(node_pool &other)
+                {
+                    std::swap(alloc_, other.alloc_);
+                    std::swap(free_, other.free_);
+                    std::swap(size_, other.size_);
+
+                    auto r = returned_.exchange(other.returned_.load(std::memory_order_acquire), std::memory_order_acq_rel);
+                    other.returned_.store(r, std::memory_order_release);
+
+                    chunks_.swap(other.chunks_);
+                    std::swap(cur_, other.cur_);
+                    std::swap(end_, other.end_);
+                    std::swap(carved_, other.carved_);
+                }
+
+                node *
+                allocate()
+                {
+                    if (slab::enabled && free_ == nullptr)
+                        collect_();
+
+                    if (free_)
+                    {
+                        auto p = free_;
+                        free_ = p->prev;
+                        size_--;
+                        return p;
+                    }
+
+                    if (slab::enabled)
+                        return carve_();
+
+                    return alloc_.allocate(1);
+                }
+
+                void
+                deallocate(node *p)
+                {
+                    if (slab::enabled || (pool_traits<Alloc>::enabled && size_ < defaults::pool_capacity))
+                    {
+                        p->prev = free_;
+                        free_ = p;
+                        size_++;
+                    }
+                    else
+                        alloc_.deallocate(p, 1);
+                }
+
+                /* slab only: nodes destroyed by other threads (disposer,
+                 * parallel dispose) are pushed here and collected by the
+                 * writer */
+
+                void
+                give_back(node *p) const
+                {
+                    auto h = returned_.load(std::memory_order_relaxed);
+                    do {
+                        p->prev = h;
+                    }
+                    while (!returned_.compare_exchange_weak(h, p, std::memory_order_release, std::memory_order_relaxed));
+                }
+
+                /* chunks carved from now on are placed on the given node */
+
+                void
+                numa_node(int n)
+                {
+                    numa_ = n;
+                }
+
+                int
+                numa_node() const
+                {
+                    return numa_;
+                }
+
+                /* chunks are released only when all their nodes are free */
+
+                void
+                release()
+                {
+                    if (slab::enabled)
+                    {
+                        collect_();
+                        if (size_ == carved_)
+                            free_chunks_();
+                        return;
+                    }
+
+                    while (free_)
+                    {
+                        auto p = free_;
+                        free_ = p->prev;
+                        alloc_.deallocate(p, 1);
+                    }
+                    size_ = 0;
+                }
+
+            private:
+
+                void
+                collect_()
+                {
+                    auto p = returned_.exchange(nullptr, std::memory_order_acquire);
+
+                    node *n;
+                    for(; p != nullptr; p = n)
+                    {
+                        n = p->prev;
+                        p->prev = free_;
+                        free_ = p;
+                        size_++;
+                    }
+                }
+
+                node *
+                carve_()
+                {
+                    if (cur_ == end_)
+                    {
+                        AllocChunk alloc(alloc_);
+
+                        auto c = alloc.allocate(bytes);
+                        chunks_.push_back(c);
+
+                        if (numa_ >= 0)
+                            numa_bind(c, bytes, numa_);
+
+                        auto addr = reinterpret_cast<uintptr_t>(c);
+                        cur_ = c + ((align - addr % align) % align);
+                        end_ = cur_ + chunk * stride;
+                    }
 
-namespace more {
+                    auto p = reinterpret_cast<node *>(cur_);
+                    cur_ += stride;
+                    carved_++;
+                    return p;
+                }
 
-    /////////////////////// Default grace period:
+                void
+                free_chunks_()
+                {
+                    AllocChunk alloc(alloc_);
 
-    namespace defaults
-    {
-        const constexpr std::chrono::milliseconds grace_period {100};
-    }
+                    for(auto c : chunks_)
+                        alloc.deallocate(c, bytes);
 
-    /////////////////////// Time Policies:
+                    chunks_.clear();
+                    free_ = nullptr;
+                    size_ = 0;
+                    cur_ = end_ = nullptr;
+                    carved_ = 0;
+                }
 
-    struct TimeStampCounter
-    {
-        typedef unsigned long long time_point;
-        typedef unsigned long long duration;
+                AllocNode alloc_;
+                node * free_;
+                size_t size_;
 
-        static time_point
-        now()
-        {
-#if defined(__i386__) && !defined(__LP64__)
-                time_point val;
-                __asm__ __volatile__("rdtsc" : "=A" (val));
-                return val;
-#endif
-#if defined(__LP64__)
-                time_point val;
-                unsigned long __a,__d;
-                __asm__ __volatile__("rdtsc" : "=a" (__a), "=d" (__d));
-                val = ((unsigned long)__a) | (((unsigned long long)__d)<<32);
-                return val;
-#endif
-        }
+                mutable std::atomic<node *> returned_;
 
-        static duration
-        grace_period()
-        {
-            typedef typename std::decay<decltype(defaults::grace_period)>::type duration_type;
-            static duration ret = clock() * defaults::grace_period.count() / duration_type(std::chrono::seconds(1)).count();
-            return ret;
-        }
+                std::vector<char *> chunks_;
+                char * cur_;
+                char * end_;
+                size_t carved_;
 
-    private:
+                int numa_;      /* not transferred by move or swap */
+            };
 
-        static uint64_t
-        clock()
-        {
-            std::ifstream cpu_info("/proc/cpuinfo");
+            Alloc alloc_;
+            node_pool pool_;
 
-            std::vector<std::string> v((std::istream_iterator<std::string>(cpu_info)), (std::istream_iterator<std::string>()));
+            reclaimer * reclaimer_;
+            std::atomic<bool> busy_;
 
-            auto it = std::find(v.begin(), v.end(), "MHz");
-            if (it == std::end(v))
-                throw std::runtime_error("TimeStampCounter::clock");
+            grace_of<Time> grace_;
 
-            auto c = std::stod(*std::next(it, 2));
-            return static_cast<uint64_t>(c) * 1000000;
-        }
-    };
+            std::unique_ptr<watermarks> marks_;
+            bool pressure_on_;
 
-    struct TimePoint
-    {
-        typedef std::chrono::high_resolution_clock::time_point   time_point;
-        typedef std::chrono::high_resolution_clock::duration     duration;
+            disposer * disposer_;
+            node * dead_;
+            size_t dead_size_;
 
-        static time_point
-        now()
-        {
-            return std::chrono::high_resolution_clock::now();
-        }
+            std::deque<deferred> deferred_;
+            std::atomic<size_t> deferred_size_;
 
-        static duration
-        grace_period()
-        {
-            return defaults::grace_period;
-        }
-    };
+            garbage garbage_;   /* destroyed first */
+        };
+    }
 
     ///////////////////// shared_list
 
@@ -131,26 +2925,29 @@ namespace more {
 
     private:
 
-        struct node
-        {
-            T                                       value;
-            typename Time::time_point               tp;
-            std::atomic<node *>                     next;
-            node *                                  prev;
-        };
+        typedef detail::shared_domain<T, Time, Alloc>         domain_type;
+        typedef typename domain_type::node                    node;
 
-        typedef typename Alloc::template rebind<node>::other  AllocNode;
+        typedef typename detail::hazard_of<Time>::type        hazard_type;
 
     public:
 
-        struct _list_iterator : std::iterator<std::forward_iterator_tag, T>
+        struct _const_list_iterator;
+
+        struct _list_iterator : std::iterator<std::forward_iterator_tag, T>, private hazard_type
         {
+            friend struct _const_list_iterator;
+
             _list_iterator()
             : node_(nullptr)
             {}
 
             explicit _list_iterator(node *p)
-            : node_(p)
+            : node_(this->publish(p))
+            {}
+
+            explicit _list_iterator(std::atomic<node *> const &src)
+            : node_(this->protect(src))
             {}
 
             reference
@@ -168,7 +2965,7 @@ namespace more {
             _list_iterator &
             operator++()
             {
-                node_ = node_->next.load(std::memory_order_acquire);
+                node_ = this->protect(node_->next);
                 return *this;
             }
 
@@ -176,7 +2973,7 @@ namespace more {
             operator++(int)
             {
                 auto self = *this;
-                node_ = node_->next.load(std::memory_order_acquire);
+                node_ = this->protect(node_->next);
                 return self;
             }
 
@@ -196,18 +2993,23 @@ namespace more {
         };
 
 
-        struct _const_list_iterator : std::iterator<std::forward_iterator_tag, const T>
+        struct _const_list_iterator : std::iterator<std::forward_iterator_tag, const T>, private hazard_type
         {
             _const_list_iterator()
             : node_(nullptr)
             {}
 
             explicit _const_list_iterator(node *p)
-            : node_(p)
+            : node_(this->publish(p))
+            {}
+
+            explicit _const_list_iterator(std::atomic<node *> const &src)
+            : node_(this->protect(src))
             {}
 
             _const_list_iterator(const _list_iterator &it)
-            : node_(it.node_)
+            : hazard_type(static_cast<hazard_type const &>(it))
+            , node_(it.node_)
             {}
 
             reference
@@ -225,7 +3027,7 @@ namespace more {
             _const_list_iterator &
             operator++()
             {
-                node_ = node_->next.load(std::memory_order_acquire);
+                node_ = this->protect(node_->next);
                 return *this;
             }
 
@@ -233,7 +3035,7 @@ namespace more {
             operator++(int)
             {
                 auto self = *this;
-                node_ = node_->next.load(std::memory_order_acquire);
+                node_ = this->protect(node_->next);
                 return self;
             }
 
@@ -262,21 +3064,25 @@ namespace more {
         explicit shared_list(const Alloc & alloc = Alloc())
         : head_(nullptr)
         , tail_(nullptr)
-        , garbage_(this)
-        , alloc_(alloc)
+        , domain_(alloc)
         {}
 
+        explicit shared_list(std::chrono::nanoseconds grace, const Alloc & alloc = Alloc())
+        : shared_list(alloc)
+        {
+            domain_.grace_period(grace);
+        }
+
         /* value intialize */
 
         explicit shared_list(size_t n)
         : head_(nullptr)
         , tail_(nullptr)
-        , garbage_(this)
-        , alloc_(Alloc())
+        , domain_()
         {
             for(unsigned int i = 0; i < n; i++)
             {
-                auto n = new_node_();
+                auto n = domain_.new_node();
                 insert_node_(head_.load(std::memory_order_relaxed), n);
             }
         }
@@ -285,12 +3091,11 @@ namespace more {
         shared_list(Iter it, Iter end, const Alloc & alloc = Alloc())
         : head_(nullptr)
         , tail_(nullptr)
-        , garbage_(this)
-        , alloc_(alloc)
+        , domain_(alloc)
         {
             for(; it != end; ++it)
             {
-                auto n = new_node_(*it);
+                auto n = domain_.new_node(*it);
                 insert_node_(nullptr, n);
             }
         }
@@ -298,12 +3103,11 @@ namespace more {
         shared_list(std::initializer_list<T> init, const Alloc & alloc = Alloc())
         : head_(nullptr)
         , tail_(nullptr)
-        , garbage_(this)
-        , alloc_(alloc)
+        , domain_(alloc)
         {
             for(auto const & elem : init)
             {
-                auto n = new_node_(elem);
+                auto n = domain_.new_node(elem);
                 insert_node_(nullptr, n);
             }
         }
@@ -325,13 +3129,11 @@ namespace more {
 
         shared_list(shared_list &&rhs)
         : head_(rhs.head_.load(std::memory_order_relaxed))
-        , tail_(rhs.tail_)
-        , garbage_(std::move(rhs.garbage_))
+        , tail_(rhs.tail_.load(std::memory_order_relaxed))
+        , domain_(std::move(rhs.domain_))
         {
-            garbage_.set_ownership(this);
-
             rhs.head_.store(nullptr, std::memory_order_relaxed);
-            rhs.tail_ = nullptr;
+            rhs.tail_.store(nullptr, std::memory_order_relaxed);
         }
 
         shared_list& operator=(shared_list &&rhs)
@@ -339,48 +3141,104 @@ namespace more {
             if (&rhs != this)
             {
                 auto p = head_.load(std::memory_order_relaxed);
+                auto t = tail_.load(std::memory_order_relaxed);
                 head_.store(rhs.head_.load(std::memory_order_relaxed));
-                tail_ = rhs.tail_;
-                destroy_list_(p);
+                tail_.store(rhs.tail_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+                destroy_list_(p, t);
                 rhs.head_.store(nullptr, std::memory_order_relaxed);
-                rhs.tail_ = nullptr;
+                rhs.tail_.store(nullptr, std::memory_order_relaxed);
 
-                garbage_ = std::move(rhs.garbage_);
-                garbage_.set_ownership(this);
+                domain_ = std::move(rhs.domain_);
             }
             return *this;
         }
 
         ~shared_list()
         {
+            this->detach();
             this->clear();
         }
 
+        /* background reclamation: to be called by the writer. Attachment
+         * is not transferred by move or swap */
+
+        void attach(reclaimer &r)
+        {
+            domain_.attach(r);
+        }
+
+        /* deferred destruction: expired elements are destroyed by the
+         * disposer threads, off the writer path */
+
+        void attach(disposer &d)
+        {
+            domain_.attach(d);
+        }
+
+        void detach()
+        {
+            domain_.detach();
+        }
+
         /***** shared and thread-safe: only affected by data-race on T (to be handled by user-code) *****/
 
         void clear()
         {
             auto h = head_.exchange(nullptr, std::memory_order_relaxed);
-            tail_ = nullptr;
-            destroy_list_(h);
+            auto t = tail_.exchange(nullptr, std::memory_order_relaxed);
+            destroy_list_(h, t);
         }
 
         size_type shrink()
         {
-            auto n = garbage_.flush();
+            auto n = domain_.flush();
             return n < 0 ? 0 : n;
         }
 
+        /* to be called by the writer: waits for the readers that could
+         * have seen an element erased before the call. With the epoch
+         * policies the caller must not be inside a read-side section */
+
+        void synchronize()
+        {
+            domain_.synchronize();
+        }
+
+        /* fun is called once the readers that could have seen an element
+         * erased before the call are gone. It must not throw */
+
+        void defer(std::function<void()> fun)
+        {
+            domain_.defer(std::move(fun));
+        }
+
+        /* thread unsafe: to be called with no readers. Elements and retired
+         * nodes are destroyed immediately, and deferred callbacks run, without
+         * waiting for the grace period */
+
+        void dispose()
+        {
+            auto h = head_.exchange(nullptr, std::memory_order_relaxed);
+            tail_.store(nullptr, std::memory_order_relaxed);
+            domain_.destroy_list(h);
+            domain_.purge();
+        }
+
+        bool attached() const noexcept
+        {
+            return domain_.attached();
+        }
+
         iterator
         begin()
         {
-            return _list_iterator(head_.load(std::memory_order_acquire));
+            return _list_iterator(head_);
         }
 
         const_iterator
         begin() const
         {
-            return _const_list_iterator(head_.load(std::memory_order_acquire));
+            return _const_list_iterator(head_);
         }
 
         iterator
@@ -397,7 +3255,7 @@ namespace more {
         const_iterator
         cbegin() const
         {
-            return _const_list_iterator(head_.load(std::memory_order_acquire));
+            return _const_list_iterator(head_);
         }
         const_iterator
         cend() const
@@ -407,7 +3265,7 @@ namespace more {
 
         Alloc get_allocator() const noexcept
         {
-            return alloc_;
+            return domain_.get_allocator();
         }
 
         reference front()
@@ -422,12 +3280,12 @@ namespace more {
 
         reference back()
         {
-            return tail_->value;
+            return tail_.load(std::memory_order_acquire)->value;
         }
 
         const_reference back() const
         {
-            return tail_->value;
+            return tail_.load(std::memory_order_acquire)->value;
         }
 
         bool empty() const noexcept
@@ -437,7 +3295,7 @@ namespace more {
 
         size_type max_size() const noexcept
         {
-            return alloc_.max_size();
+            return domain_.max_size();
         }
 
         size_type size() noexcept
@@ -468,7 +3326,7 @@ namespace more {
         reverse_size() noexcept
         {
             size_type c = 0;
-            node * t = tail_;
+            node * t = tail_.load(std::memory_order_relaxed);
             while (t)
             {
                 t = t->prev;
@@ -487,7 +3345,7 @@ namespace more {
                 std::cout << "|" << (void *)n->prev << " " << n->value  << " " << n->next.load(std::memory_order_relaxed) << "|-" << n << " ";
                 n = n->next.load(std::memory_order_relaxed);
             }
-            std::cout << " ] <= " << tail_ << std::endl;
+            std::cout << " ] <= " << tail_.load(std::memory_order_relaxed) << std::endl;
         }
 
         void push_back(const T&value)
@@ -517,37 +3375,101 @@ namespace more {
 
         void pop_back()
         {
-            this->erase(iterator(tail_));
+            this->erase(iterator(tail_.load(std::memory_order_relaxed)));
         }
 
         template <typename ...Ts>
         void emplace_back(Ts && ...args)
         {
-            auto n = new_node_(std::forward<Ts>(args)...);
+            auto n = domain_.new_node(std::forward<Ts>(args)...);
             insert_node_(nullptr, n);
         }
 
         template <typename ...Ts>
         void emplace_front(Ts && ...args)
         {
-            auto n = new_node_(std::forward<Ts>(args)...);
+            auto n = domain_.new_node(std::forward<Ts>(args)...);
             insert_node_(head_.load(std::memory_order_relaxed), n);
         }
 
+        /***** multiple producers *****/
+
+        /* appends from any number of threads, concurrently with each other
+         * and with the readers; the tail is advanced by CAS, the lagging
+         * one being helped forward (Michael-Scott). Meanwhile the writer
+         * may only erase elements followed by another one (e.g. consume
+         * from the front of a list holding more than one): any other
+         * writer operation requires the producers to be stopped. Producers
+         * count as readers for the reclamation policy (e.g. they hold an
+         * EpochBased::guard). Not available with slab allocators */
+
+        void concurrent_push_back(const T &value)
+        {
+            this->concurrent_emplace_back(value);
+        }
+
+        void concurrent_push_back(T &&value)
+        {
+            this->concurrent_emplace_back(std::move(value));
+        }
+
+        template <typename ...Ts>
+        void concurrent_emplace_back(Ts && ...args)
+        {
+            static_assert(!detail::slab_traits<Alloc>::enabled, "shared_list: concurrent appends need a thread-safe allocator");
+
+            auto n = domain_.new_concurrent_node(std::forward<Ts>(args)...);
+            n->next.store(nullptr, std::memory_order_relaxed);
+
+            hazard_type hz;
+
+            for(;;)
+            {
+                auto t = hz.protect(tail_);
+
+                if (t == nullptr)
+                {
+                    node * h = nullptr;
+                    n->prev = nullptr;
+                    if (head_.compare_exchange_strong(h, n, std::memory_order_release, std::memory_order_relaxed))
+                    {
+                        tail_.compare_exchange_strong(t, n, std::memory_order_release, std::memory_order_relaxed);
+                        return;
+                    }
+
+                    /* another producer got the empty list first */
+                    tail_.compare_exchange_strong(t, h, std::memory_order_release, std::memory_order_relaxed);
+                    continue;
+                }
+
+                auto next = t->next.load(std::memory_order_acquire);
+                if (next)
+                {
+                    tail_.compare_exchange_strong(t, next, std::memory_order_release, std::memory_order_relaxed);
+                    continue;
+                }
+
+                n->prev = t;
+                if (t->next.compare_exchange_weak(next, n, std::memory_order_release, std::memory_order_relaxed))
+                {
+                    tail_.compare_exchange_strong(t, n, std::memory_order_release, std::memory_order_relaxed);
+                    return;
+                }
+            }
+        }
+
         void swap(shared_list &other)
         {
             auto that = head_.exchange(other.head_.load(std::memory_order_relaxed), std::memory_order_relaxed);
             other.head_.store(that, std::memory_order_relaxed);
-            std::swap(tail_, other.tail_);
-            std::swap(garbage_, other.garbage_);
-
-            garbage_.set_ownership(&other);
-            other.garbage_.set_ownership(this);
+            auto t = tail_.exchange(other.tail_.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            other.tail_.store(t, std::memory_order_relaxed);
+            domain_.swap(other.domain_);
         }
 
         iterator insert(const_iterator pos, const T& value)
         {
-            auto n = new_node_(value);
+            auto n = domain_.new_node(value);
             insert_node_(pos.node_, n);
             return iterator(n);
         }
@@ -564,7 +3486,7 @@ namespace more {
 
         iterator atomic_assign(iterator pos, const T &value)
         {
-            auto n = new_node_(value);
+            auto n = domain_.new_node(value);
 
             auto del = pos.node_;
             auto nxt = del->next.load(std::memory_order_relaxed);
@@ -580,142 +3502,169 @@ namespace more {
 
             n->prev = del->prev;
 
-            if (nxt)
+            if (nxt) {
                 nxt->prev = n;
+                tail_past_(del, n);
+            }
             else
-                tail_ = n;
+                tail_.store(n, std::memory_order_relaxed);
 
-            garbage_.free(del);
+            domain_.retire(del);
 
             return iterator(n);
         }
 
         iterator erase(const_iterator pos)
         {
-            if (pos.node_ == tail_) {
-                auto that = tail_;
-                if (tail_->prev)
-                    tail_->prev->next.store(nullptr, std::memory_order_release);
+            auto that = pos.node_;
+            auto next = that->next.load(std::memory_order_acquire);
+
+            if (next == nullptr) {
+                if (that->prev)
+                    that->prev->next.store(nullptr, std::memory_order_release);
                 else
                     head_.store(nullptr, std::memory_order_release);
-                tail_ = tail_->prev;
-                garbage_.free(that);
+                tail_.store(that->prev, std::memory_order_relaxed);
+                domain_.retire(that);
                 return iterator(nullptr);
             }
-            else if (pos == begin()) {
-                auto that = head_.load(std::memory_order_relaxed);
-                head_.store(that->next.load(std::memory_order_relaxed), std::memory_order_release);
-                head_.load(std::memory_order_relaxed)->prev = nullptr;
-                garbage_.free(that);
-                return iterator(tail_);
+            else if (that->prev == nullptr) {
+                head_.store(next, std::memory_order_release);
+                next->prev = nullptr;
+                tail_past_(that, next);
+                domain_.retire(that);
+                return iterator(tail_.load(std::memory_order_relaxed));
             }
             else {
-                auto that = pos.node_;
-                auto next = that->next.load(std::memory_order_relaxed);
                 that->prev->next.store(next, std::memory_order_release);
                 next->prev = that->prev;
-                garbage_.free(that);
+                tail_past_(that, next);
+                domain_.retire(that);
                 return iterator(next);
             }
         }
 
-        static typename Time::duration
-        grace_period()
+        /* the range is unlinked at once and retired as a batch */
+
+        iterator erase(const_iterator first, const_iterator last)
         {
-            return Time::grace_period();
-        }
+            if (first == last)
+                return iterator(last.node_);
 
-    private:
+            auto front = first.node_;
+            auto back  = last.node_ ? last.node_->prev : tail_.load(std::memory_order_relaxed);
+            auto pred  = front->prev;
 
-        /* value intialize */
+            /* the range is walked once to count it and to relink it for
+             * the garbage in list order */
 
-        node * new_node_()
-        {
-            node * p = nullptr;
-            try
-            {
-                p = allocnode_.allocate(1);
-            }
-            catch(...)
+            size_type n = 1;
+            for(auto p = front; p != back; n++)
             {
-                if (p) allocnode_.deallocate(p, 1);
-                throw;
+                auto next = p->next.load(std::memory_order_relaxed);
+                if (last.node_)
+                    tail_past_(p, last.node_);
+                p->prev = next;
+                p = next;
             }
 
-            try
-            {
-                alloc_.construct(&p->value, T());
-            }
-            catch(...)
-            {
-                allocnode_.deallocate(p, 1);
-                throw;
-            }
-            return p;
+            if (last.node_)
+                tail_past_(back, last.node_);
+
+            if (pred)
+                pred->next.store(last.node_, std::memory_order_release);
+            else
+                head_.store(last.node_, std::memory_order_release);
+
+            if (last.node_)
+                last.node_->prev = pred;
+            else
+                tail_.store(pred, std::memory_order_relaxed);
+
+            back->prev = nullptr;
+            domain_.retire_chain(front, back, n);
+
+            return iterator(last.node_);
         }
 
-        node * new_node_(const T &value)
+        /* per-container grace period, for the time policies: defaults to
+         * Time::grace_period() and can be changed at any time. Like the
+         * attachment, it is not transferred by move or swap */
+
+        typename Time::duration
+        grace_period() const
         {
-            node * p = nullptr;
-            try
-            {
-                p = allocnode_.allocate(1);
-            }
-            catch(...)
-            {
-                if (p) allocnode_.deallocate(p, 1);
-                throw;
-            }
+            return domain_.grace_period();
+        }
 
-            try
-            {
-                alloc_.construct(&p->value, value);
-            }
-            catch(...)
-            {
-                allocnode_.deallocate(p, 1);
-                throw;
-            }
-            return p;
+        void grace_period(std::chrono::nanoseconds d)
+        {
+            domain_.grace_period(d);
         }
 
-        template <typename ...Ts>
-        node * new_node_(Ts && ...args)
+        /* garbage memory pressure: to be set by the writer */
+
+        void set_watermarks(watermarks const &w)
         {
-            node * p = nullptr;
-            try
-            {
-                p = allocnode_.allocate(1);
-            }
-            catch(...)
-            {
-                if (p) allocnode_.deallocate(p, 1);
-                throw;
-            }
+            domain_.set_watermarks(w);
+        }
 
-            try
-            {
-                alloc_.construct(&p->value, std::forward<Ts>(args)...);
-            }
-            catch(...)
-            {
-                allocnode_.deallocate(p, 1);
-                throw;
-            }
-            return p;
+        size_type garbage_size() const noexcept
+        {
+            return domain_.garbage_size();
+        }
+
+        size_type garbage_bytes() const noexcept
+        {
+            return domain_.garbage_bytes();
+        }
+
+        /* time policies only: the grace period follows the read latency
+         * sampled by read_latency<Tag>::guard, until a fixed one is set */
+
+        template <typename Tag = void>
+        void adapt_grace_period()
+        {
+            domain_.template adapt_grace_period<Tag>();
+        }
+
+        /* time policies only: retired nodes skip the grace period whenever
+         * a scan (shrink, or one every scan_threshold erasures) finds no
+         * reader inside a read_section<Tag>::guard */
+
+        template <typename Tag = void>
+        void track_readers()
+        {
+            domain_.template track_readers<Tag>();
+        }
+
+        /* with a slab_allocator, the chunks carved from now on are bound to
+         * the given NUMA node (-1 for none). Not transferred by move or swap */
+
+        void numa_node(int n)
+        {
+            domain_.numa_node(n);
+        }
+
+        int numa_node() const
+        {
+            return domain_.numa_node();
         }
 
+    private:
+
         void
         insert_node_(node *pos, node *n)
         {
             if (pos == nullptr) {
                 n->next.store(nullptr, std::memory_order_relaxed);
-                if (tail_)
-                    tail_->next.store(n, std::memory_order_release);
+                auto t = tail_.load(std::memory_order_relaxed);
+                if (t)
+                    t->next.store(n, std::memory_order_release);
                 else
                     head_.store(n, std::memory_order_release);
-                n->prev = tail_;
-                tail_ = n;
+                n->prev = t;
+                tail_.store(n, std::memory_order_relaxed);
             }
             else if (pos == head_.load(std::memory_order_relaxed)) {
                 n->next.store(head_.load(std::memory_order_relaxed), std::memory_order_relaxed);
@@ -731,151 +3680,36 @@ namespace more {
             }
         }
 
-        void destroy_node_(node *n)
-        {
-            alloc_.destroy(&n->value);
-            allocnode_.deallocate(n, 1);
-        }
+        /* the tail an appender left on a node being erased moves past it,
+         * before the node is retired. A no-op for a single writer */
 
-        void destroy_list_(node *p)
+        void
+        tail_past_(node *p, node *next)
         {
-            node *q;
-            for(; p != nullptr; p = q)
-            {
-                q = p->next.load(std::memory_order_relaxed);
-                garbage_.free(p);
-            }
+            if (tail_.load(std::memory_order_relaxed) == p)
+                tail_.compare_exchange_strong(p, next, std::memory_order_release, std::memory_order_relaxed);
         }
 
-        struct garbage
-        {
-            garbage(shared_list *l)
-            : owner_(l)
-            , ptr_(nullptr)
-            , tail_(nullptr)
-            {}
-
-            ~garbage()
-            {
-                while(this->flush() != -1)
-                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
-            }
-
-            garbage(const garbage &) = delete;
-            garbage& operator=(const garbage &) = delete;
-
-            garbage(garbage &&other)
-            {
-                ptr_  = other.ptr_, other.ptr_ = nullptr;
-                tail_ = other.tail_, other.tail_ = nullptr;
-                owner_ = nullptr;
-            }
-
-            garbage& operator=(garbage &&other)
-            {
-                while(this->flush() != -1)
-                    std::this_thread::sleep_for(std::chrono::milliseconds(1));
-
-                ptr_ = other.ptr_, other.ptr_ = nullptr;
-                tail_ = other.tail_, other.tail_ = nullptr;
-                owner_ = nullptr;
-                return *this;
-            }
-
-            void
-            set_ownership(shared_list *l)
-            {
-                owner_ = l;
-            }
-
-
-            void free(node *p)
-            {
-                auto now = Time::now();
-
-                p->tp    = now;
-                p->prev  = nullptr;
-
-                if (tail_)
-                {
-                    tail_->prev = p;
-                }
-                else
-                {
-                    ptr_ = p;
-                }
-
-                tail_ = p;
-
-                if (now - ptr_->tp > Time::grace_period())
-                {
-                    auto q = ptr_;
-                    ptr_ = ptr_->prev;
-                    delete q;
-                }
-            }
-
-
-            node *
-            recycle()
-            {
-                auto p = ptr_;
-
-                if (p && (Time::now() - p->tp > Time::grace_period()))
-                {
-                    ptr_ = ptr_->prev;
-                    return p;
-                }
-                return nullptr;
-            }
+        /* the nodes are relinked through prev in list order, head first */
 
-            std::ptrdiff_t
-            flush()
+        void destroy_list_(node *head, node *tail)
+        {
+            size_type n = 0;
+            for(auto p = head; p != nullptr; n++)
             {
-                node *q = nullptr, *p = ptr_, *n;
-
-                if (p == nullptr)
-                    return -1;
-
-                auto now = Time::now();
-
-                size_type ret = 0;
-
-                for(; p != nullptr; p = n)
-                {
-                    n = p->prev;
-
-                    if (now - p->tp > Time::grace_period())
-                    {
-                        if (q)
-                            q->prev = n;
-                        else
-                            ptr_ = n;
-
-                        ret++;
-                        owner_->destroy_node_(p);
-                    }
-                    else
-                        break;
-                }
-
-                return ret;
+                auto next = p->next.load(std::memory_order_relaxed);
+                p->prev = next;
+                p = next;
             }
 
-        private:
-
-            shared_list * owner_;
-            node * ptr_;
-            node * tail_;
-        };
+            if (n)
+                domain_.retire_chain(head, tail, n);
+        }
 
         std::atomic<node *>  head_;
-        node * tail_;
-
-        garbage garbage_;
+        std::atomic<node *>  tail_;
 
-        Alloc alloc_;
-        AllocNode allocnode_;
+        domain_type domain_;
     };
 }
 
@@ -0,0 +1,459 @@
+/*
+ *  Copyright (c) 2011-2014 Bonelli Nicola <nicola.bonelli@cnit.it>
+ *                          Loris Gazzarrini <loris.gazzarrini@for.iet.unipi.it>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef __SHARED_ORDERED_LIST_HPP__
+#define __SHARED_ORDERED_LIST_HPP__
+
+#include <shared_list.hpp>
+
+#include <cstdint>
+
+namespace more {
+
+    ///////////////////// shared_ordered_list
+    //
+    // A sorted list of unique elements with any number of writers, none of
+    // them holding a lock (Harris-Michael): erase marks the next link of
+    // the node first, so that no insert can follow it any longer, then
+    // unlinks it. Writers that meet a marked node help unlinking it. The
+    // thread whose CAS unlinks a node retires it into the garbage of the
+    // domain, as in shared_list: the retired nodes of all the writers are
+    // pushed on a lock-free stack and moved into the garbage by whichever
+    // writer finds it free.
+    //
+    // Readers traverse wait-free and skip the marked nodes. Writers count
+    // as readers for the reclamation policy (e.g. they hold an
+    // EpochBased::guard), which also keeps a node from being reused while
+    // a CAS can still expect it. Only the ordered policies are supported,
+    // and not with slab allocators.
+    //
+
+    template <typename T, typename Time = TimeStampCounter, typename Compare = std::less<T>, typename Alloc = std::allocator<T> >
+    struct shared_ordered_list
+    {
+        static_assert(Time::ordered, "shared_ordered_list: the reclamation policy must be ordered");
+        static_assert(!detail::slab_traits<Alloc>::enabled, "shared_ordered_list: writers need a thread-safe allocator");
+
+    public:
+
+        typedef T                                   value_type;
+        typedef Compare                             value_compare;
+        typedef Alloc                               allocator_type;
+        typedef std::size_t                         size_type;
+        typedef std::ptrdiff_t                      difference_type;
+
+        typedef const value_type &                  const_reference;
+        typedef const value_type *                  const_pointer;
+
+    private:
+
+        typedef detail::shared_domain<T, Time, Alloc>         domain_type;
+        typedef typename domain_type::node                    node;
+
+        /* the low bit of next marks the node as erased */
+
+        static bool
+        marked_(node *p)
+        {
+            return reinterpret_cast<std::uintptr_t>(p) & 1;
+        }
+
+        static node *
+        mark_(node *p)
+        {
+            return reinterpret_cast<node *>(reinterpret_cast<std::uintptr_t>(p) | 1);
+        }
+
+        static node *
+        unmark_(node *p)
+        {
+            return reinterpret_cast<node *>(reinterpret_cast<std::uintptr_t>(p) & ~std::uintptr_t(1));
+        }
+
+        /* the first node from p on that is not erased */
+
+        static node *
+        live_(node *p)
+        {
+            while (p)
+            {
+                auto n = p->next.load(std::memory_order_acquire);
+                if (!marked_(n))
+                    break;
+                p = unmark_(n);
+            }
+            return p;
+        }
+
+    public:
+
+        struct _const_list_iterator : std::iterator<std::forward_iterator_tag, const T>
+        {
+            _const_list_iterator()
+            : node_(nullptr)
+            {}
+
+            explicit _const_list_iterator(node *p)
+            : node_(live_(p))
+            {}
+
+            const_reference
+            operator*() const
+            {
+                return node_->value;
+            }
+
+            const_pointer
+            operator->() const
+            {
+                return &node_->value;
+            }
+
+            _const_list_iterator &
+            operator++()
+            {
+                node_ = live_(unmark_(node_->next.load(std::memory_order_acquire)));
+                return *this;
+            }
+
+            _const_list_iterator
+            operator++(int)
+            {
+                auto self = *this;
+                ++*this;
+                return self;
+            }
+
+            bool
+            operator==(const _const_list_iterator &it)
+            {
+                return node_ == it.node_;
+            }
+
+            bool
+            operator!=(const _const_list_iterator &it)
+            {
+                return node_ != it.node_;
+            }
+
+            node * node_;
+        };
+
+        typedef _const_list_iterator     iterator;
+        typedef _const_list_iterator     const_iterator;
+
+    public:
+
+        /* thread unsafe: to be called with no traversing visitors */
+
+        explicit shared_ordered_list(const Compare & comp = Compare(), const Alloc & alloc = Alloc())
+        : head_(nullptr)
+        , comp_(comp)
+        , retired_(nullptr)
+        , busy_(false)
+        , domain_(alloc)
+        {}
+
+        explicit shared_ordered_list(std::chrono::nanoseconds grace, const Compare & comp = Compare(), const Alloc & alloc = Alloc())
+        : shared_ordered_list(comp, alloc)
+        {
+            domain_.grace_period(grace);
+        }
+
+        shared_ordered_list(const shared_ordered_list &) = delete;
+        shared_ordered_list& operator=(const shared_ordered_list &) = delete;
+
+        ~shared_ordered_list()
+        {
+            node *n;
+            for(auto p = head_.exchange(nullptr, std::memory_order_relaxed); p != nullptr; p = n)
+            {
+                n = unmark_(p->next.load(std::memory_order_relaxed));
+                domain_.retire(p);
+            }
+
+            collect_();
+        }
+
+        /***** multiple writers *****/
+
+        /* false if an equivalent element is already there */
+
+        bool insert(const T &value)
+        {
+            return this->emplace(value);
+        }
+
+        bool insert(T &&value)
+        {
+            return this->emplace(std::move(value));
+        }
+
+        template <typename ...Ts>
+        bool emplace(Ts && ...args)
+        {
+            auto n = new_node_(std::forward<Ts>(args)...);
+
+            std::atomic<node *> *prev;
+            node *cur;
+
+            for(;;)
+            {
+                if (search_(n->value, prev, cur))
+                {
+                    n->next.store(nullptr, std::memory_order_relaxed);
+                    domain_.destroy_list(n);
+                    return false;
+                }
+
+                n->next.store(cur, std::memory_order_relaxed);
+                if (prev->compare_exchange_weak(cur, n, std::memory_order_release, std::memory_order_relaxed))
+                    return true;
+            }
+        }
+
+        /* false if no equivalent element is there */
+
+        bool erase(const T &value)
+        {
+            std::atomic<node *> *prev;
+            node *cur;
+
+            for(;;)
+            {
+                if (!search_(value, prev, cur))
+                    return false;
+
+                auto next = cur->next.load(std::memory_order_acquire);
+                if (marked_(next))
+                    continue;
+
+                /* logical deletion: from now on cur belongs to the writer
+                 * that marked it */
+
+                if (!cur->next.compare_exchange_weak(next, mark_(next), std::memory_order_release, std::memory_order_relaxed))
+                    continue;
+
+                auto expected = cur;
+                if (prev->compare_exchange_strong(expected, next, std::memory_order_release, std::memory_order_relaxed))
+                    retire_(cur);
+                else
+                    search_(value, prev, cur);
+
+                return true;
+            }
+        }
+
+        /* move the retired nodes into the garbage and free the expired ones */
+
+        size_type shrink()
+        {
+            collect_();
+
+            if (busy_.exchange(true, std::memory_order_acquire))
+                return 0;
+
+            auto n = domain_.flush();
+            busy_.store(false, std::memory_order_release);
+            return n < 0 ? 0 : n;
+        }
+
+        /* per-list grace period, for the time policies */
+
+        typename Time::duration
+        grace_period() const
+        {
+            return domain_.grace_period();
+        }
+
+        void grace_period(std::chrono::nanoseconds d)
+        {
+            domain_.grace_period(d);
+        }
+
+        size_type garbage_size() const noexcept
+        {
+            return domain_.garbage_size();
+        }
+
+        /***** shared and thread-safe: wait-free *****/
+
+        const_iterator
+        find(const T &value) const
+        {
+            for(auto it = begin(); it != end(); ++it)
+            {
+                if (!comp_(*it, value))
+                    return comp_(value, *it) ? end() : it;
+            }
+            return end();
+        }
+
+        bool contains(const T &value) const
+        {
+            return find(value) != end();
+        }
+
+        const_iterator
+        begin() const
+        {
+            return const_iterator(head_.load(std::memory_order_acquire));
+        }
+
+        const_iterator
+        end() const
+        {
+            return const_iterator();
+        }
+
+        const_iterator
+        cbegin() const
+        {
+            return begin();
+        }
+
+        const_iterator
+        cend() const
+        {
+            return end();
+        }
+
+        bool empty() const noexcept
+        {
+            return begin() == end();
+        }
+
+        size_type size() const noexcept
+        {
+            size_type c = 0;
+            for(auto it = begin(); it != end(); ++it)
+                c++;
+            return c;
+        }
+
+        Alloc get_allocator() const noexcept
+        {
+            return domain_.get_allocator();
+        }
+
+    private:
+
+        /* prev is the link to cur, the first node not less than value;
+         * marked nodes met on the way are unlinked */
+
+        bool
+        search_(const T &value, std::atomic<node *> *&prev, node *&cur)
+        {
+        retry:
+            prev = &head_;
+            cur  = prev->load(std::memory_order_acquire);
+
+            while (cur)
+            {
+                auto next = cur->next.load(std::memory_order_acquire);
+
+                if (marked_(next))
+                {
+                    auto expected = cur;
+                    if (!prev->compare_exchange_strong(expected, unmark_(next), std::memory_order_release, std::memory_order_relaxed))
+                        goto retry;
+
+                    retire_(cur);
+                    cur = unmark_(next);
+                    continue;
+                }
+
+                if (!comp_(cur->value, value))
+                    return !comp_(value, cur->value);
+
+                prev = &cur->next;
+                cur  = next;
+            }
+
+            return false;
+        }
+
+        /* nodes are recycled from the garbage when no other writer is
+         * using the domain */
+
+        template <typename ...Ts>
+        node *
+        new_node_(Ts && ...args)
+        {
+            if (busy_.exchange(true, std::memory_order_acquire))
+                return domain_.new_concurrent_node(std::forward<Ts>(args)...);
+
+            node *n;
+            try
+            {
+                n = domain_.new_node(std::forward<Ts>(args)...);
+            }
+            catch(...)
+            {
+                busy_.store(false, std::memory_order_release);
+                throw;
+            }
+
+            busy_.store(false, std::memory_order_release);
+            return n;
+        }
+
+        /* unlinked nodes are stacked through prev */
+
+        void
+        retire_(node *p)
+        {
+            auto h = retired_.load(std::memory_order_relaxed);
+            do {
+                p->prev = h;
+            }
+            while (!retired_.compare_exchange_weak(h, p, std::memory_order_release, std::memory_order_relaxed));
+
+            collect_();
+        }
+
+        void
+        collect_()
+        {
+            if (retired_.load(std::memory_order_relaxed) == nullptr ||
+                busy_.exchange(true, std::memory_order_acquire))
+                return;
+
+            node *n;
+            for(auto p = retired_.exchange(nullptr, std::memory_order_acquire); p != nullptr; p = n)
+            {
+                n = p->prev;
+                domain_.retire(p);
+            }
+
+            busy_.store(false, std::memory_order_release);
+        }
+
+        std::atomic<node *> head_;
+        Compare comp_;
+
+        std::atomic<node *> retired_;
+        std::atomic<bool> busy_;
+
+        domain_type domain_;
+    };
+}
+
+#endif /* __SHARED_ORDERED_LIST_HPP__ */
@@ -0,0 +1,212 @@
+/*
+ *  Copyright (c) 2011-2014 Bonelli Nicola <nicola.bonelli@cnit.it>
+ *                          Loris Gazzarrini <loris.gazzarrini@for.iet.unipi.it>
+ *
+ *  This program is free software; you can redistribute it and/or modify
+ *  it under the terms of the GNU General Public License as published by
+ *  the Free Software Foundation; either version 2 of the License, or
+ *  (at your option) any later version.
+ *
+ *  This program is distributed in the hope that it will be useful,
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ *  GNU General Public License for more details.
+ *
+ *  You should have received a copy of the GNU General Public License
+ *  along with this program; if not, write to the Free Software
+ *  Foundation, Inc., 59 Temple Place - Suite 330, Boston, MA 02111-1307, USA.
+ *
+ */
+
+#ifndef __SHARED_RECLAIMER_HPP__
+#define __SHARED_RECLAIMER_HPP__
+
+#include <atomic>
+#include <memory>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <chrono>
+#include <algorithm>
+
+namespace more {
+
+    /////////////////////// Default reclaimer settings:
+
+    namespace defaults
+    {
+        const constexpr std::chrono::milliseconds reclaim_period {10};
+
+        /* nodes reclaimed per container in a single pass */
+
+        const constexpr size_t reclaim_budget = 4096;
+    }
+
+    ///////////////////// reclaimer
+    //
+    // Background service that periodically flushes the expired garbage of
+    // the containers attached to it, so that memory is returned even when
+    // writers go quiet. Containers are visited in turn by one or more
+    // worker threads; each visit reclaims at most budget nodes and is
+    // skipped if the writer is holding the container garbage.
+    //
+
+    class reclaimer
+    {
+    public:
+
+        explicit reclaimer(std::chrono::milliseconds period = defaults::reclaim_period,
+                           size_t budget = defaults::reclaim_budget,
+                           size_t threads = 1)
+        : period_(period)
+        , budget_(budget)
+        , stop_(false)
+        , reclaimed_(0)
+        , passes_(0)
+        {
+            for(size_t i = 0; i < threads; i++)
+                threads_.emplace_back(&reclaimer::run_, this, i, threads);
+        }
+
+        ~reclaimer()
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                stop_ = true;
+            }
+
+            cond_.notify_all();
+
+            for(auto &t : threads_)
+                t.join();
+        }
+
+        reclaimer(const reclaimer &) = delete;
+        reclaimer& operator=(const reclaimer &) = delete;
+
+        /* fun(budget) reclaims up to budget nodes and returns how many */
+
+        void attach(void const *key, std::function<size_t(size_t)> fun)
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            entries_.emplace_back(new entry{key, std::move(fun), false});
+        }
+
+        /* once detached, the container is no longer visited */
+
+        void detach(void const *key)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+
+            auto it = std::find_if(entries_.begin(), entries_.end(),
+                                   [key](std::unique_ptr<entry> const &e) { return e->key == key; });
+            if (it == entries_.end())
+                return;
+
+            auto e = it->get();
+
+            cond_.wait(lock, [e] { return !e->busy; });
+
+            entries_.erase(std::find_if(entries_.begin(), entries_.end(),
+                                        [e](std::unique_ptr<entry> const &x) { return x.get() == e; }));
+        }
+
+        /* run a pass in the calling thread */
+
+        size_t reclaim()
+        {
+            return pass_(0, 1);
+        }
+
+        size_t reclaimed() const
+        {
+            return reclaimed_.load(std::memory_order_relaxed);
+        }
+
+        size_t passes() const
+        {
+            return passes_.load(std::memory_order_relaxed);
+        }
+
+        size_t budget() const
+        {
+            return budget_;
+        }
+
+        std::chrono::milliseconds period() const
+        {
+            return period_;
+        }
+
+    private:
+
+        struct entry
+        {
+            void const *                    key;
+            std::function<size_t(size_t)>   fun;
+            bool                            busy;
+        };
+
+        void run_(size_t id, size_t n)
+        {
+            std::unique_lock<std::mutex> lock(mutex_);
+
+            while (!stop_)
+            {
+                cond_.wait_for(lock, period_, [this] { return stop_; });
+                if (stop_)
+                    break;
+
+                lock.unlock();
+                pass_(id, n);
+                lock.lock();
+            }
+        }
+
+        /* visit the entries id, id+n, id+2n... */
+
+        size_t pass_(size_t id, size_t n)
+        {
+            size_t total = 0;
+
+            std::unique_lock<std::mutex> lock(mutex_);
+
+            for(size_t i = id; i < entries_.size(); i += n)
+            {
+                auto e = entries_[i].get();
+                if (e->busy)
+                    continue;
+
+                e->busy = true;
+                lock.unlock();
+
+                total += e->fun(budget_);
+
+                lock.lock();
+                e->busy = false;
+                cond_.notify_all();
+            }
+
+            reclaimed_.fetch_add(total, std::memory_order_relaxed);
+            passes_.fetch_add(1, std::memory_order_relaxed);
+            return total;
+        }
+
+        std::chrono::milliseconds period_;
+        size_t budget_;
+
+        std::mutex mutex_;
+        std::condition_variable cond_;
+        std::vector<std::unique_ptr<entry>> entries_;
+        bool stop_;
+
+        std::atomic<size_t> reclaimed_;
+        std::atomic<size_t> passes_;
+
+        std::vector<std::thread> threads_;
+    };
+}
+
+#endif /* __SHARED_RECLAIMER_HPP__ */
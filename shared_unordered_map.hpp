@@ -28,6 +28,7 @@
 #include <vector>
 #include <atomic>
 #include <tuple>
+#include <thread>
 
 #include <shared_list.hpp>
 
@@ -61,7 +62,16 @@ namespace more
         typedef typename std::allocator_traits<Alloc>::const_pointer     const_pointer;
 
     private:
-        typedef shared_list<value_type, Time, Alloc>    __list_type;
+        typedef shared_list<value_type, Time, Alloc>            __list_type;
+
+        /* buckets are bare list heads: nodes, allocator and retired garbage
+         * are owned by a single reclamation domain */
+
+        typedef detail::shared_domain<value_type, Time, Alloc>  __domain_type;
+        typedef typename __domain_type::node                    __node_type;
+        typedef std::atomic<__node_type *>                      __bucket_type;
+        typedef std::vector<__bucket_type,
+                typename Alloc::template rebind<__bucket_type>::other> __table_type;
 
     public:
         typedef typename __list_type::iterator          local_iterator;
@@ -69,13 +79,13 @@ namespace more
 
         struct _iterator : std::iterator<std::forward_iterator_tag, value_type>
         {
-            explicit _iterator(std::vector<__list_type> *bucket)
+            explicit _iterator(__table_type *bucket)
             : bucket_(bucket)
             , lit_()
             , index_(-1)
             {}
 
-            _iterator(std::vector<__list_type> *bucket, local_iterator it, size_type index)
+            _iterator(__table_type *bucket, local_iterator it, size_type index)
             : bucket_(bucket)
             , lit_(it)
             , index_(index)
@@ -97,13 +107,13 @@ namespace more
             operator++()
             {
                 if (*this != _iterator(bucket_))
-                    if (++lit_ != (*bucket_)[index_].end())
+                    if (++lit_ != local_iterator())
                         return *this;
                 do {
                     index_++;
                 }
                 while(index_ < bucket_->size() &&
-                        ((lit_ = (*bucket_)[index_].begin()), lit_ == (*bucket_)[index_].end()));
+                        ((lit_ = local_iterator((*bucket_)[index_])), lit_ == local_iterator()));
 
                 if (index_ == bucket_->size())
                     *this = _iterator(bucket_);
@@ -131,7 +141,7 @@ namespace more
                 return lit_ != it.lit_;
             }
 
-            std::vector<__list_type> * bucket_;
+            __table_type * bucket_;
             local_iterator lit_;
             size_type index_;
         };
@@ -139,13 +149,13 @@ namespace more
 
         struct _const_iterator : std::iterator<std::forward_iterator_tag, const value_type>
         {
-            explicit _const_iterator(std::vector<__list_type> const *bucket)
+            explicit _const_iterator(__table_type const *bucket)
             : bucket_(bucket)
             , lit_()
             , index_(-1)
             {}
 
-            _const_iterator(std::vector<__list_type> const *bucket, const_local_iterator it, size_type index)
+            _const_iterator(__table_type const *bucket, const_local_iterator it, size_type index)
             : bucket_(bucket)
             , lit_(it)
             , index_(index)
@@ -175,13 +185,13 @@ namespace more
             operator++()
             {
                 if (*this != _const_iterator(bucket_))
-                    if (++lit_ != (*bucket_)[index_].end())
+                    if (++lit_ != const_local_iterator())
                         return *this;
                 do {
                     index_++;
                 }
                 while(index_ < bucket_->size() &&
-                        ((lit_ = (*bucket_)[index_].begin()), lit_ == (*bucket_)[index_].end()));
+                        ((lit_ = const_local_iterator((*bucket_)[index_])), lit_ == const_local_iterator()));
 
                 if (index_ == bucket_->size())
                     *this = _const_iterator(bucket_);
@@ -210,7 +220,7 @@ namespace more
             }
 
 
-            std::vector<__list_type> const * bucket_;
+            __table_type const * bucket_;
             const_local_iterator lit_;
             size_type index_;
         };
@@ -230,8 +240,19 @@ namespace more
         , hash_(hash)
         , equal_(pred)
         , size_(0)
+        , domain_(alloc)
         {
+            init_buckets_();
+        }
 
+        shared_unordered_map(size_type bucket,
+                            std::chrono::nanoseconds grace,
+                            const Hash &hash   = Hash(),
+                            const Pred &pred   = Pred(),
+                            const Alloc &alloc = Alloc())
+        : shared_unordered_map(bucket, hash, pred, alloc)
+        {
+            domain_.grace_period(grace);
         }
 
         template <typename Input>
@@ -243,7 +264,9 @@ namespace more
         : bucket_(bucket)
         , hash_(hash)
         , equal_(pred)
+        , domain_(alloc)
         {
+            init_buckets_();
 
             for(; beg != end; ++beg)
             {
@@ -257,7 +280,10 @@ namespace more
         : bucket_(other.bucket_.size())
         , hash_(other.hash_)
         , equal_(other.equal_)
+        , domain_(other.domain_.get_allocator())
         {
+            init_buckets_();
+
             for(auto &value : other)
                 insert_(value);
 
@@ -268,7 +294,10 @@ namespace more
         : bucket_(other.bucket_.size())
         , hash_(other.hash_)
         , equal_(other.equal_)
+        , domain_(alloc)
         {
+            init_buckets_();
+
             for(auto &value : other)
                 insert_(value);
 
@@ -282,6 +311,7 @@ namespace more
         : bucket_(std::move(other.bucket_))
         , hash_(std::move(other.hash_))
         , equal_(std::move(other.equal_))
+        , domain_(std::move(other.domain_))
         {
             size_.store(total_size_(), std::memory_order_release);
         }
@@ -295,7 +325,10 @@ namespace more
         : bucket_(bucket)
         , hash_(hash)
         , equal_(pred)
+        , domain_(alloc)
         {
+            init_buckets_();
+
             for(auto &value : init)
                 insert_(value);
 
@@ -304,10 +337,10 @@ namespace more
 
         shared_unordered_map& operator=(shared_unordered_map const & other)
         {
-            bucket_ = other.bucket_;
-            hash_   = other.hash_;
-            equal_   = other.equal_;
-            size_.store(total_size_(), std::memory_order_release);
+            /* swap idiom */
+
+            shared_unordered_map local(other);
+            local.swap(*this);
             return *this;
         }
 
@@ -316,18 +349,23 @@ namespace more
 
         shared_unordered_map& operator=(shared_unordered_map&& other)
         {
-            bucket_ = std::move(other.bucket_);
-            hash_   = std::move(other.hash_);
-            equal_   = std::move(other.equal_);
-            size_.store(total_size_(), std::memory_order_release);
+            if (&other != this)
+            {
+                this->clear();
+
+                bucket_ = std::move(other.bucket_);
+                hash_   = std::move(other.hash_);
+                equal_   = std::move(other.equal_);
+                domain_ = std::move(other.domain_);
+                size_.store(total_size_(), std::memory_order_release);
+            }
             return *this;
         }
 
         ~shared_unordered_map()
         {
-            /* enable parallel distruction */
-            for(auto &buc : bucket_)
-                buc.clear();
+            this->detach();
+            this->clear();
         }
 
 
@@ -437,19 +475,18 @@ namespace more
         {
             size_.fetch_sub(1, std::memory_order_relaxed);
 
-            auto buc = & const_cast<__list_type &>((*position.bucket_)[position.index_]);
-
-            auto lit = buc->erase(position.lit_);
-            if (lit != buc->end())
-                return iterator(const_cast<std::vector<__list_type> *>(position.bucket_), lit, position.index_);
-
             auto index = position.index_;
+            auto next  = erase_node_(index, position.lit_.node_);
+            if (next)
+                return iterator(&bucket_, local_iterator(next), index);
+
+            local_iterator lit;
 
             do {
-                index++, buc++;
+                index++;
             }
             while(index < bucket_.size() &&
-                  ((lit = buc->begin(), lit == buc->end())));
+                  ((lit = local_iterator(bucket_[index]), lit == local_iterator())));
 
             if (index == bucket_.size())
                 return iterator(&bucket_);
@@ -464,7 +501,7 @@ namespace more
                 return 0;
 
             size_.fetch_sub(1, std::memory_order_relaxed);
-            bucket_[std::get<1>(p)].erase(std::get<0>(p));
+            erase_node_(std::get<1>(p), std::get<0>(p).node_);
             return 1;
         }
 
@@ -483,14 +520,206 @@ namespace more
         void clear() noexcept
         {
             size_.store(0, std::memory_order_relaxed);
-            for(auto &l : bucket_)
-                l.clear();
+
+            /* the chains of all the buckets are retired as a single batch */
+
+            __node_type *front = nullptr, *back = nullptr;
+            size_type n = 0;
+
+            for(auto &b : bucket_)
+            {
+                auto h = b.exchange(nullptr, std::memory_order_relaxed);
+                if (h == nullptr)
+                    continue;
+
+                /* relinked in chain order, head first */
+
+                auto t = h;
+                for(n++; ; n++)
+                {
+                    auto next = t->next.load(std::memory_order_relaxed);
+                    t->prev = next;
+                    if (next == nullptr)
+                        break;
+                    t = next;
+                }
+
+                if (back)
+                    back->prev = h;
+                else
+                    front = h;
+
+                back = t;
+            }
+
+            domain_.retire_chain(front, back, n);
+        }
+
+        // wait for the readers that could have seen an element erased
+        // before the call (to be called by the writer, outside of any
+        // read-side section of the epoch policies)
+        //
+
+        void synchronize()
+        {
+            domain_.synchronize();
         }
 
-        void shrink() noexcept
+        // fun is called once the same grace period has elapsed, by the
+        // writer or the reclaimer thread. It must not throw
+        //
+
+        void defer(std::function<void()> fun)
         {
-            for(auto &l : bucket_)
-                l.shrink();
+            domain_.defer(std::move(fun));
+        }
+
+        // No observers are allowed while disposing: elements and retired
+        // nodes are destroyed immediately and deferred callbacks are run.
+        // Buckets are split among the given number of threads, which the
+        // caller still waits for. With a disposer attached, they go to its
+        // threads in as many batches instead, and the call returns without
+        // waiting for the destruction
+        //
+
+        void dispose(size_type threads = 1)
+        {
+            auto n = size_.exchange(0, std::memory_order_relaxed);
+
+            if (domain_.disposing())
+            {
+                std::vector<__node_type *> chains;
+                for(auto &b : bucket_)
+                {
+                    if (auto p = b.exchange(nullptr, std::memory_order_relaxed))
+                        chains.push_back(p);
+                }
+
+                domain_.hand_over(std::move(chains), threads, n);
+                return;
+            }
+
+            if (threads > 1)
+            {
+                std::vector<std::thread> workers;
+
+                for(size_type id = 0; id < threads; id++)
+                    workers.emplace_back([this, id, threads]
+                    {
+                        for(size_type i = id; i < bucket_.size(); i += threads)
+                            domain_.destroy_list(bucket_[i].exchange(nullptr, std::memory_order_relaxed));
+                    });
+
+                for(auto &w : workers)
+                    w.join();
+            }
+            else
+            {
+                for(auto &b : bucket_)
+                    domain_.destroy_list(b.exchange(nullptr, std::memory_order_relaxed));
+            }
+
+            domain_.purge();
+        }
+
+        size_type shrink() noexcept
+        {
+            auto n = domain_.flush();
+            return n < 0 ? 0 : n;
+        }
+
+        // background reclamation (to be called by the writer)
+        //
+
+        void attach(reclaimer &r)
+        {
+            domain_.attach(r);
+        }
+
+        // deferred destruction of the expired elements
+        //
+
+        void attach(disposer &d)
+        {
+            domain_.attach(d);
+        }
+
+        void detach()
+        {
+            domain_.detach();
+        }
+
+        // per-map grace period, for the time policies: defaults to
+        // Time::grace_period() and can be changed at any time. It is not
+        // transferred by move or swap
+        //
+
+        typename Time::duration
+        grace_period() const
+        {
+            return domain_.grace_period();
+        }
+
+        void grace_period(std::chrono::nanoseconds d)
+        {
+            domain_.grace_period(d);
+        }
+
+        // garbage memory pressure (to be set by the writer)
+        //
+
+        void set_watermarks(watermarks const &w)
+        {
+            domain_.set_watermarks(w);
+        }
+
+        size_type garbage_size() const noexcept
+        {
+            return domain_.garbage_size();
+        }
+
+        size_type garbage_bytes() const noexcept
+        {
+            return domain_.garbage_bytes();
+        }
+
+        // the grace period follows the read latency sampled by
+        // read_latency<Tag>::guard, until a fixed one is set
+        //
+
+        template <typename Tag = void>
+        void adapt_grace_period()
+        {
+            domain_.template adapt_grace_period<Tag>();
+        }
+
+        // retired elements skip the grace period whenever a scan (shrink,
+        // or one every scan_threshold erasures) finds no reader inside a
+        // read_section<Tag>::guard (time policies only)
+        //
+
+        template <typename Tag = void>
+        void track_readers()
+        {
+            domain_.template track_readers<Tag>();
+        }
+
+        // bind the bucket array, and with a slab_allocator the node chunks
+        // carved from now on, to the given NUMA node (-1 for none). To be
+        // called by the writer; not transferred by move or swap
+        //
+
+        void numa_node(int n)
+        {
+            if (!bucket_.empty())
+                detail::numa_bind(bucket_.data(), bucket_.size() * sizeof(bucket_[0]), n);
+
+            domain_.numa_node(n);
+        }
+
+        int numa_node() const
+        {
+            return domain_.numa_node();
         }
 
         // No observers are allowed while swapping
@@ -499,6 +728,7 @@ namespace more
         void swap(shared_unordered_map& other)
         {
             bucket_.swap(other.bucket_);
+            domain_.swap(other.domain_);
             std::swap(hash_,other.hash_);
             std::swap(equal_,other.equal_);
 
@@ -568,9 +798,9 @@ namespace more
             auto p = find_(k);
             if (!std::get<2>(p))
             {
-                auto &l = bucket_[std::get<1>(p)];
-                l.emplace_front(k, mapped_type());
-                std::get<0>(p) = l.begin();
+                auto n = domain_.new_node(k, mapped_type());
+                push_front_(std::get<1>(p), n);
+                std::get<0>(p) = local_iterator(n);
 
                 size_.fetch_add(1, std::memory_order_relaxed);
             }
@@ -583,9 +813,9 @@ namespace more
             auto p = find_(k);
             if (!std::get<2>(p))
             {
-                auto &l = bucket_[std::get<1>(p)];
-                l.emplace_front(std::move(k), mapped_type());
-                std::get<0>(p) = l.begin();
+                auto n = domain_.new_node(std::move(k), mapped_type());
+                push_front_(std::get<1>(p), n);
+                std::get<0>(p) = local_iterator(n);
 
                 size_.fetch_add(1, std::memory_order_relaxed);
             }
@@ -636,32 +866,32 @@ namespace more
 
         local_iterator begin(size_type n)
         {
-            return bucket_[n].begin();
+            return local_iterator(bucket_[n]);
         }
 
         const_local_iterator begin(size_type n) const
         {
-            return bucket_[n].begin();
+            return const_local_iterator(bucket_[n]);
         }
 
-        local_iterator end(size_type n)
+        local_iterator end(size_type)
         {
-            return bucket_[n].end();
+            return local_iterator();
         }
 
-        const_local_iterator end(size_type n) const
+        const_local_iterator end(size_type) const
         {
-            return bucket_[n].end();
+            return const_local_iterator();
         }
 
         const_local_iterator cbegin(size_type n) const
         {
-            return bucket_[n].cbegin();
+            return const_local_iterator(bucket_[n]);
         }
 
-        const_local_iterator cend(size_type n) const
+        const_local_iterator cend(size_type) const
         {
-            return bucket_[n].cend();
+            return const_local_iterator();
         }
 
         float
@@ -673,13 +903,13 @@ namespace more
         void dump() const
         {
             auto n = 0;
-            for(auto const &l : bucket_)
+            for(auto const &b : bucket_)
             {
                 std::cout << "[" << n << "] => ";
 
-                for(auto const &e : l)
+                for(const_local_iterator it(b); it != const_local_iterator(); ++it)
                 {
-                    std::cout << "(" << e.first << "," << e.second << ") " << std::flush;
+                    std::cout << "(" << it->first << "," << it->second << ") " << std::flush;
                 }
 
                 n++;
@@ -697,7 +927,7 @@ namespace more
             auto index = bucket(value.first);
             auto &buc = bucket_.at(index);
 
-            for(auto it = buc.begin(); it != buc.end(); ++it)
+            for(local_iterator it(buc); it != local_iterator(); ++it)
             {
                 if (it->first == value.first)
                 {
@@ -705,9 +935,46 @@ namespace more
                 }
             }
 
-            buc.push_front(std::forward<Tp>(value));
+            auto n = domain_.new_node(std::forward<Tp>(value));
+            push_front_(index, n);
+
+            return std::make_tuple(local_iterator(n), index, true);
+        }
+
+        /* chains are doubly linked: prev is only used by the writer */
+
+        void push_front_(size_type index, __node_type *n)
+        {
+            auto &buc = bucket_[index];
+            auto h = buc.load(std::memory_order_relaxed);
+
+            n->prev = nullptr;
+            n->next.store(h, std::memory_order_relaxed);
+            if (h)
+                h->prev = n;
+            buc.store(n, std::memory_order_release);
+        }
+
+        /* unlink and retire the node, return its successor */
+
+        __node_type *
+        erase_node_(size_type index, __node_type *that)
+        {
+            auto &buc = bucket_[index];
+
+            auto prev = that->prev;
+            auto next = that->next.load(std::memory_order_relaxed);
 
-            return std::make_tuple(buc.begin(), index, true);
+            if (prev)
+                prev->next.store(next, std::memory_order_release);
+            else
+                buc.store(next, std::memory_order_release);
+
+            if (next)
+                next->prev = prev;
+
+            domain_.retire(that);
+            return next;
         }
 
 
@@ -717,7 +984,7 @@ namespace more
             auto index = bucket(k);
             auto & buc = bucket_.at(index);
 
-            for(auto it = buc.begin(); it != buc.end(); ++it)
+            for(local_iterator it(buc); it != local_iterator(); ++it)
             {
                 if (it->first == k)
                     return std::make_tuple(it, index, true);
@@ -733,7 +1000,7 @@ namespace more
             auto index = bucket(k);
             auto & buc = bucket_.at(index);
 
-            for(auto it = buc.begin(); it != buc.end(); ++it)
+            for(const_local_iterator it(buc); it != const_local_iterator(); ++it)
             {
                 if (it->first == k)
                     return std::make_tuple(it, index, true);
@@ -746,17 +1013,26 @@ namespace more
         {
             size_type n = 0;
             for(auto & b : bucket_)
-                n += b.size();
+                for(auto p = b.load(std::memory_order_relaxed); p; p = p->next.load(std::memory_order_relaxed))
+                    n++;
             return n;
         }
 
-        std::vector<__list_type, typename Alloc::template rebind<__list_type>::other> bucket_;
+        void init_buckets_() noexcept
+        {
+            for(auto & b : bucket_)
+                b.store(nullptr, std::memory_order_relaxed);
+        }
+
+        __table_type bucket_;
 
         Hash hash_;
         Pred equal_;
 
         std::atomic<size_type>  size_;
 
+        __domain_type domain_;
+
     };
 
     template <typename Key,
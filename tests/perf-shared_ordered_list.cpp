@@ -0,0 +1,108 @@
+#include <yats.hpp>
+
+#include <shared_ordered_list.hpp>
+
+#include <algorithm>
+#include <iostream>
+#include <list>
+#include <mutex>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace yats;
+
+
+// sorted set with a single lock, as the baseline
+//
+
+struct locked_list
+{
+    bool insert(int k)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = std::lower_bound(list_.begin(), list_.end(), k);
+        if (it != list_.end() && *it == k)
+            return false;
+        list_.insert(it, k);
+        return true;
+    }
+
+    bool erase(int k)
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        auto it = std::lower_bound(list_.begin(), list_.end(), k);
+        if (it == list_.end() || *it != k)
+            return false;
+        list_.erase(it);
+        return true;
+    }
+
+    std::list<int> list_;
+    std::mutex mutex_;
+};
+
+
+Context(writers)
+{
+    const int keys = 1024;
+    const int ops  = 1 << 18;
+
+    /* every thread inserts and erases random keys, half and half */
+
+    template <typename List>
+    void run(const char *name)
+    {
+        for(int writers = 1; writers <= 16; writers *= 2)
+        {
+            List l;
+
+            for(int k = 0; k < keys; k += 2)
+                l.insert(k);
+
+            std::vector<std::thread> ws;
+
+            auto start = std::chrono::steady_clock::now();
+
+            for(int id = 0; id < writers; id++)
+            {
+                ws.emplace_back([&l, id] {
+                    std::mt19937 gen(id);
+                    for(int i = 0; i < ops; i++)
+                    {
+                        auto k = static_cast<int>(gen() % keys);
+                        if (i & 1)
+                            l.insert(k);
+                        else
+                            l.erase(k);
+                    }
+                });
+            }
+
+            for(auto &w : ws)
+                w.join();
+
+            auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+            std::cout << name << ": " << writers << " writers, "
+                      << 1000.0 * writers * ops / ns << " Mops/s" << std::endl;
+        }
+    }
+
+    Test(std_list_mutex)
+    {
+        run<locked_list>("std::list + std::mutex");
+    }
+
+    Test(shared_ordered_list)
+    {
+        run<more::shared_ordered_list<int>>("shared_ordered_list");
+    }
+}
+
+
+int
+main(int argc, char * argv[])
+{
+    return yats::run(argc, argv);
+}
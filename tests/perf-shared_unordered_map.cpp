@@ -0,0 +1,134 @@
+#include <yats.hpp>
+
+#include <shared_unordered_map.hpp>
+
+#include <random>
+#include <iostream>
+
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+using namespace yats;
+
+
+// dTLB load misses of the calling thread, -1 where perf events are not
+// available (e.g. in containers or with perf_event_paranoid > 2)
+//
+
+struct tlb_misses
+{
+    tlb_misses()
+    {
+        perf_event_attr attr = {};
+        attr.type   = PERF_TYPE_HW_CACHE;
+        attr.size   = sizeof(attr);
+        attr.config = PERF_COUNT_HW_CACHE_DTLB |
+                      (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                      (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+        attr.disabled = 1;
+        attr.exclude_kernel = 1;
+        attr.exclude_hv = 1;
+
+        fd_ = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+    }
+
+    ~tlb_misses()
+    {
+        if (fd_ >= 0)
+            close(fd_);
+    }
+
+    void start()
+    {
+        if (fd_ >= 0)
+        {
+            ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+            ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+        }
+    }
+
+    long long stop()
+    {
+        long long n = -1;
+        if (fd_ >= 0)
+        {
+            ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+            if (read(fd_, &n, sizeof(n)) != sizeof(n))
+                n = -1;
+        }
+        return n;
+    }
+
+private:
+    int fd_;
+};
+
+
+Context(find)
+{
+    const int entries = 1 << 21;
+    const int lookups = 1 << 24;
+
+    long long misses[2] = { -1, -1 };
+
+    template <typename Map>
+    long long run(const char *name)
+    {
+        Map m(entries);
+
+        for(int i = 0; i < entries; i++)
+            m[i] = i;
+
+        std::mt19937 gen(42);
+        std::uniform_int_distribution<int> dist(0, entries - 1);
+
+        std::vector<int> keys(1 << 20);
+        for(auto &k : keys)
+            k = dist(gen);
+
+        tlb_misses tlb;
+
+        auto start = std::chrono::steady_clock::now();
+        tlb.start();
+
+        long long sum = 0;
+        for(int i = 0; i < lookups; i++)
+            sum += m.find(keys[i & (keys.size() - 1)])->second;
+
+        auto n = tlb.stop();
+        auto ns = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+        std::cout << name << ": " << static_cast<double>(ns) / lookups << " ns/find, ";
+        if (n < 0)
+            std::cout << "dTLB misses n/a";
+        else
+            std::cout << static_cast<double>(n) / lookups << " dTLB misses/find";
+        std::cout << " (" << sum << ")" << std::endl;
+
+        return n;
+    }
+
+    Test(std_allocator)
+    {
+        misses[0] = run<more::shared_unordered_map<int, int>>("std::allocator");
+    }
+
+    Test(huge_page_allocator)
+    {
+        misses[1] = run<more::shared_unordered_map<int, int, more::TimeStampCounter,
+                                                   std::hash<int>, std::equal_to<int>,
+                                                   more::huge_page_allocator<std::pair<const int, int>>>>("huge_page_allocator");
+
+        if (misses[0] > 0 && misses[1] >= 0)
+            std::cout << "dTLB miss reduction: " << 100.0 * (misses[0] - misses[1]) / misses[0] << "%" << std::endl;
+    }
+}
+
+
+int
+main(int argc, char * argv[])
+{
+    return yats::run(argc, argv);
+}
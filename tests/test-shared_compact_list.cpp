@@ -0,0 +1,159 @@
+#include <yats.hpp>
+
+#include <shared_compact_list.hpp>
+
+#include <vector>
+#include <thread>
+
+using namespace yats;
+
+
+Context(single_thread)
+{
+    typedef more::shared_compact_list<int, more::TimePoint> list_type;
+
+    Test(push)
+    {
+        list_type l(8);
+
+        Assert(l.empty());
+        Assert(l.capacity(), is_equal_to(8));
+
+        l.push_back(2);
+        l.push_back(3);
+        l.push_front(1);
+
+        Assert(l.size(), is_equal_to(3));
+        Assert(l.front(), is_equal_to(1));
+        Assert(l.back(), is_equal_to(3));
+
+        std::vector<int> v(l.cbegin(), l.cend());
+        Assert(v, is_equal_to(std::vector<int>{1,2,3}));
+    }
+
+    Test(insert_erase)
+    {
+        list_type l(8);
+
+        l.push_back(1);
+        l.push_back(3);
+        l.insert(std::next(l.cbegin()), 2);
+
+        auto it = l.erase(l.cbegin());
+        Assert(*it, is_equal_to(2));
+
+        l.pop_back();
+
+        Assert(l.size(), is_equal_to(1));
+        Assert(l.front(), is_equal_to(2));
+        Assert(l.garbage_size(), is_equal_to(2));
+
+        l.dispose();
+        Assert(l.empty());
+        Assert(l.garbage_size(), is_equal_to(0));
+    }
+
+    Test(capacity)
+    {
+        list_type l(4, std::chrono::seconds(10));
+
+        for(int i = 0; i < 4; i++)
+            l.push_back(i);
+
+        AssertThrow(l.push_back(4));
+
+        /* retired slots come back after the grace period only */
+
+        l.pop_front();
+        AssertThrow(l.push_back(4));
+
+        l.grace_period(std::chrono::milliseconds(1));
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+        l.push_back(4);
+
+        std::vector<int> v(l.cbegin(), l.cend());
+        Assert(v, is_equal_to(std::vector<int>{1,2,3,4}));
+        Assert(l.garbage_size(), is_equal_to(0));
+    }
+
+    Test(batches)
+    {
+        list_type l(256, std::chrono::milliseconds(1));
+
+        for(int i = 0; i < 200; i++)
+            l.push_back(i);
+
+        /* two closed batches and an open one */
+
+        for(int i = 0; i < 130; i++)
+            l.pop_front();
+
+        Assert(l.garbage_size(), is_equal_to(130));
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+        Assert(l.shrink(), is_equal_to(130));
+        Assert(l.garbage_size(), is_equal_to(0));
+        Assert(l.size(), is_equal_to(70));
+        Assert(l.front(), is_equal_to(130));
+    }
+
+    Test(compact)
+    {
+        struct five_tuple
+        {
+            uint32_t src, dst;
+            uint16_t sport, dport;
+            uint8_t  proto;
+        };
+
+        more::shared_compact_list<five_tuple, more::TimePoint> l(2);
+
+        l.push_back(five_tuple{1, 2, 3, 4, 17});
+        Assert(l.front().proto, is_equal_to(17));
+    }
+}
+
+
+Context(epoch_based)
+{
+    typedef more::shared_compact_list<int, more::EpochBased> list_type;
+
+    Test(reader_thread)
+    {
+        list_type l(4);
+
+        for(int i = 0; i < 4; i++)
+            l.push_back(i);
+
+        std::atomic<int> state(0);
+
+        std::thread t([&] {
+            more::EpochBased::guard g;
+            state.store(1);
+            while (state.load() != 2)
+                std::this_thread::yield();
+        });
+
+        while (state.load() != 1)
+            std::this_thread::yield();
+
+        l.pop_front();
+        Assert(l.shrink(), is_equal_to(0));
+        AssertThrow(l.push_back(4));
+
+        state.store(2);
+        t.join();
+
+        l.push_back(4);
+        Assert(l.garbage_size(), is_equal_to(0));
+    }
+}
+
+
+int
+main(int argc, char * argv[])
+{
+    return yats::run(argc, argv);
+}
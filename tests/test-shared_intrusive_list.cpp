@@ -0,0 +1,295 @@
+#include <yats.hpp>
+
+#include <shared_intrusive_list.hpp>
+
+#include <vector>
+#include <string>
+#include <thread>
+
+using namespace yats;
+
+
+template <typename Time>
+struct flow
+{
+    flow(int n = 0)
+    : id(n)
+    {}
+
+    int id;
+    more::shared_list_hook<Time> hook;
+};
+
+
+Context(single_thread)
+{
+    typedef flow<more::TimePoint> flow_type;
+    typedef more::shared_intrusive_list<flow_type, more::TimePoint, &flow_type::hook> list_type;
+
+    Test(link)
+    {
+        std::vector<flow_type> pool {1,2,3,4,5};
+
+        list_type l;
+
+        Assert(l.empty());
+
+        for(auto &f : pool)
+            l.push_back(f);
+
+        /* objects are linked in place */
+
+        Assert(&l.front() == &pool[0]);
+        Assert(&l.back() == &pool[4]);
+        Assert(l.size(), is_equal_to(5));
+
+        std::vector<int> v;
+        for(auto &f : l)
+            v.push_back(f.id);
+
+        Assert(v, is_equal_to(std::vector<int>{1,2,3,4,5}));
+    }
+
+    Test(insert_erase)
+    {
+        std::vector<flow_type> pool {1,2,3,4};
+
+        list_type l;
+
+        l.push_back(pool[0]);
+        l.push_back(pool[2]);
+        l.insert(std::next(l.cbegin()), pool[1]);
+        l.push_front(pool[3]);
+
+        std::vector<int> v;
+        for(auto it = l.cbegin(); it != l.cend(); ++it)
+            v.push_back(it->id);
+
+        Assert(v, is_equal_to(std::vector<int>{4,1,2,3}));
+
+        auto it = l.erase(std::next(l.cbegin()));
+        Assert(it->id, is_equal_to(2));
+
+        l.pop_front();
+        l.pop_back();
+
+        Assert(l.size(), is_equal_to(1));
+        Assert(l.front().id, is_equal_to(2));
+        Assert(l.garbage_size(), is_equal_to(3));
+
+        l.dispose();
+        Assert(l.empty());
+        Assert(l.garbage_size(), is_equal_to(0));
+    }
+
+    struct session
+    {
+        session(int n = 0)
+        : id(n)
+        {}
+
+        virtual ~session()
+        {}
+
+        int id;
+        std::string name;
+        more::shared_list_hook<more::TimePoint> hook;
+    };
+
+    Test(polymorphic)
+    {
+        typedef more::shared_intrusive_list<session, more::TimePoint, &session::hook> session_list;
+
+        std::vector<session> pool {1,2,3};
+        std::vector<session *> free;
+
+        session_list l(std::chrono::milliseconds(1), [&](session *s) { free.push_back(s); });
+
+        for(auto &s : pool)
+            l.push_back(s);
+
+        /* not a standard-layout type: objects are found through their hooks */
+
+        Assert(&l.front() == &pool[0]);
+        Assert(&*std::next(l.begin()) == &pool[1]);
+        Assert(&l.back() == &pool[2]);
+
+        l.clear();
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+        Assert(l.shrink(), is_equal_to(3));
+        Assert(free, is_equal_to(std::vector<session *>{&pool[0], &pool[1], &pool[2]}));
+    }
+
+    Test(release_on_erase)
+    {
+        std::vector<flow_type> pool {1,2,3,4,5};
+        std::vector<flow_type *> free;
+
+        list_type l(std::chrono::milliseconds(1), [&](flow_type *f) { free.push_back(f); });
+
+        for(auto &f : pool)
+            l.push_back(f);
+
+        l.pop_front();
+        l.pop_front();
+        l.pop_front();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+        /* an erase alone hands back every object expired so far */
+
+        l.pop_front();
+
+        Assert(free, is_equal_to(std::vector<flow_type *>{&pool[0], &pool[1], &pool[2]}));
+        Assert(l.garbage_size(), is_equal_to(1));
+    }
+
+    Test(release)
+    {
+        std::vector<flow_type> pool {1,2,3,4,5,6,7,8,9,10};
+        std::vector<flow_type *> free;
+
+        {
+            list_type l(std::chrono::seconds(10), [&](flow_type *f) { free.push_back(f); });
+
+            for(auto &f : pool)
+                l.push_back(f);
+
+            for(int i = 0; i < 5; i++)
+                l.pop_front();
+
+            Assert(l.shrink(), is_equal_to(0));
+            Assert(free.empty());
+
+            l.grace_period(std::chrono::milliseconds(1));
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+            /* objects go back to their owner in retirement order */
+
+            Assert(l.shrink(), is_equal_to(5));
+            Assert(free.size(), is_equal_to(5));
+            Assert(free[0] == &pool[0]);
+            Assert(free[4] == &pool[4]);
+
+            /* a released object can be linked again */
+
+            l.push_back(*free.back());
+            free.pop_back();
+
+            Assert(l.back().id, is_equal_to(5));
+        }
+
+        /* the linked ones are released on destruction */
+
+        Assert(free.size(), is_equal_to(10));
+    }
+}
+
+
+Context(epoch_based)
+{
+    typedef flow<more::EpochBased> flow_type;
+    typedef more::shared_intrusive_list<flow_type, more::EpochBased, &flow_type::hook> list_type;
+
+    Test(reader_thread)
+    {
+        std::vector<flow_type> pool {1,2,3};
+        size_t released = 0;
+
+        list_type l([&](flow_type *) { released++; });
+
+        for(auto &f : pool)
+            l.push_back(f);
+
+        std::atomic<int> state(0);
+
+        std::thread t([&] {
+            more::EpochBased::guard g;
+            state.store(1);
+            while (state.load() != 2)
+                std::this_thread::yield();
+        });
+
+        while (state.load() != 1)
+            std::this_thread::yield();
+
+        l.pop_front();
+        Assert(l.shrink(), is_equal_to(0));
+
+        state.store(2);
+        t.join();
+
+        Assert(l.shrink(), is_equal_to(1));
+        Assert(released, is_equal_to(1));
+    }
+}
+
+
+Context(hazard_pointer)
+{
+    typedef flow<more::HazardPointer> flow_type;
+    typedef more::shared_intrusive_list<flow_type, more::HazardPointer, &flow_type::hook> list_type;
+
+    Test(protected_iterator)
+    {
+        std::vector<flow_type> pool {1,2,3,4,5};
+        size_t released = 0;
+
+        list_type l([&](flow_type *) { released++; });
+
+        for(auto &f : pool)
+            l.push_back(f);
+
+        {
+            auto it = std::next(l.cbegin(), 2);
+
+            for(int i = 0; i < 5; i++)
+                l.pop_front();
+
+            /* 3 and the nodes retired after it are still reachable */
+
+            Assert(l.shrink(), is_equal_to(2));
+            Assert(it->id, is_equal_to(3));
+            Assert((++it)->id, is_equal_to(4));
+        }
+
+        Assert(l.shrink(), is_equal_to(3));
+        Assert(released, is_equal_to(5));
+    }
+
+    Test(clear_iterating)
+    {
+        std::vector<flow_type> pool {1,2,3,4};
+        size_t released = 0;
+
+        list_type l([&](flow_type *) { released++; });
+
+        for(auto &f : pool)
+            l.push_back(f);
+
+        {
+            auto it = std::next(l.cbegin());
+
+            /* the objects are retired in list order, so that the ones
+             * after the iterator stay reachable */
+
+            l.clear();
+
+            Assert(l.shrink(), is_equal_to(1));
+            Assert(it->id, is_equal_to(2));
+            Assert((++it)->id, is_equal_to(3));
+            Assert((++it)->id, is_equal_to(4));
+        }
+
+        Assert(l.shrink(), is_equal_to(3));
+        Assert(released, is_equal_to(4));
+    }
+}
+
+
+int
+main(int argc, char * argv[])
+{
+    return yats::run(argc, argv);
+}
@@ -1,6 +1,7 @@
 #include <yats.hpp>
 
 #include <thread>
+#include <vector>
 #include <shared_list.hpp>
 
 using namespace yats;
@@ -394,6 +395,68 @@ Context(multiple_thread)
         t2.join();
     }
 
+
+    Test(concurrent_push_back)
+    {
+        const int producers = 4;
+        const int count = 250000;
+
+        more::shared_list<std::pair<int, int>> l;
+
+        stop.store(false, std::memory_order_relaxed);
+
+        std::thread t(visitor(), [&]() -> bool
+                      {
+                            int last[producers] = { -1, -1, -1, -1 };
+                            for(auto const &e : l)
+                            {
+                                if (e.second <= last[e.first])
+                                    return false;
+                                last[e.first] = e.second;
+                            }
+                            return true;
+                      });
+
+        std::atomic<int> done(0);
+
+        std::vector<std::thread> ps;
+        for(int id = 0; id < producers; id++)
+        {
+            ps.emplace_back([&, id] {
+                for(int i = 0; i < count; i++)
+                    l.concurrent_push_back(std::make_pair(id, i));
+                done++;
+            });
+        }
+
+        /* the writer consumes from the front, never the last element */
+
+        int last[producers] = { -1, -1, -1, -1 };
+        size_t consumed = 0;
+
+        while (done.load() < producers)
+        {
+            auto it = l.begin();
+            if (it == l.end() || std::next(it) == l.end())
+                continue;
+
+            Assert(it->second > last[it->first]);
+            last[it->first] = it->second;
+
+            l.pop_front();
+            consumed++;
+        }
+
+        for(auto &p : ps)
+            p.join();
+
+        stop.store(true, std::memory_order_relaxed);
+        t.join();
+
+        Assert(consumed + l.size(), is_equal_to(size_t(producers * count)));
+        Assert(l.back().second, is_equal_to(count - 1));
+    }
+
 }
 
 
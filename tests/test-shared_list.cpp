@@ -6,6 +6,64 @@
 using namespace yats;
 
 
+static std::atomic<long> allocated;
+
+template <typename T>
+struct counting_allocator : std::allocator<T>
+{
+    template <typename U>
+    struct rebind
+    {
+        typedef counting_allocator<U> other;
+    };
+
+    counting_allocator() = default;
+
+    template <typename U>
+    counting_allocator(counting_allocator<U> const &)
+    {}
+
+    T * allocate(size_t n)
+    {
+        allocated += n;
+        return std::allocator<T>::allocate(n);
+    }
+
+    void deallocate(T *p, size_t n)
+    {
+        allocated -= n;
+        std::allocator<T>::deallocate(p, n);
+    }
+};
+
+
+/* the memory policy of the page at addr: false where the host has no
+ * NUMA support to ask */
+
+static bool
+numa_policy(void const *addr, int &mode, int &node)
+{
+    if (access("/sys/devices/system/node/node0", F_OK) != 0 ||
+        syscall(__NR_mbind, nullptr, 0, MPOL_DEFAULT, nullptr, 0, 0) != 0)
+        return false;
+
+    unsigned long mask[16] = { 0 };
+    if (syscall(__NR_get_mempolicy, &mode, mask, 16 * 8 * sizeof(unsigned long), addr, MPOL_F_ADDR) != 0)
+        return false;
+
+    node = -1;
+    for(int n = 0; n < 16 * 8 * static_cast<int>(sizeof(unsigned long)); n++)
+    {
+        if (mask[n / (8 * sizeof(unsigned long))] & (1UL << (n % (8 * sizeof(unsigned long)))))
+        {
+            node = n;
+            break;
+        }
+    }
+    return true;
+}
+
+
 Context(single_thread)
 {
 
@@ -735,6 +793,726 @@ Context(single_thread)
     }
 
 
+    Test(allocator)
+    {
+        allocated.store(0);
+        {
+            more::shared_list<int, more::EpochBased, counting_allocator<int>> l {1,2,3,4,5,6,7,8,9,10};
+
+            Assert(allocated.load(), is_equal_to(10));
+
+            for(int i = 0; i < 10; i++)
+                l.pop_front();
+
+            l.shrink();
+
+            for(int i = 0; i < 10; i++)
+                l.push_back(i);
+
+            /* nodes come back from the garbage or the pool */
+
+            Assert(allocated.load(), is_equal_to(10));
+        }
+        Assert(allocated.load(), is_equal_to(0));
+    }
+
+    Test(tsc_calibration)
+    {
+        more::TimeStampCounter::init();
+
+        auto hz = more::TimeStampCounter::frequency();
+        Assert(hz > 0);
+
+        auto t0 = more::TimeStampCounter::now();
+        std::this_thread::sleep_for(std::chrono::milliseconds(50));
+        auto t1 = more::TimeStampCounter::now();
+
+        /* ticks match the wall time within a generous margin */
+
+        auto ms = (t1 - t0) * 1000 / hz;
+        Assert(ms >= 45 && ms < 200);
+
+        Assert(more::TimeStampCounter::grace_period(), is_equal_to(hz / 10));
+    }
+
+    Test(grace_period)
+    {
+        more::shared_list<int, more::TimePoint> l(std::chrono::milliseconds(1));
+
+        Assert(l.grace_period() == std::chrono::milliseconds(1));
+
+        l = {1,2,3,4,5};
+        for(int i = 0; i < 5; i++)
+            l.pop_front();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+        Assert(l.shrink() > 0);
+        Assert(l.shrink(), is_equal_to(0));
+
+        more::shared_list<int> t;
+        Assert(t.grace_period(), is_equal_to(more::TimeStampCounter::grace_period()));
+
+        t.grace_period(std::chrono::milliseconds(10));
+        Assert(t.grace_period(), is_equal_to(more::TimeStampCounter::grace_period() / 10));
+    }
+
+    Test(adaptive_grace_period)
+    {
+        struct tag;
+        typedef more::read_latency<tag> latency;
+
+        more::shared_list<int> l {1,2,3};
+
+        l.adapt_grace_period<tag>();
+        Assert(l.grace_period(), is_equal_to(more::TimeStampCounter::grace_period()));
+
+        for(int i = 0; i < 100; i++)
+        {
+            latency::guard g;
+            for(auto &e : l)
+                (void)e;
+        }
+
+        Assert(latency::samples(), is_equal_to(100));
+        Assert(latency::percentile(0.5) > 0);
+
+        /* short readers: the grace period shrinks, down to the floor */
+
+        l.shrink();
+
+        Assert(l.grace_period() >= more::TimeStampCounter::ticks(more::defaults::read_grace_floor));
+        Assert(l.grace_period() <  more::TimeStampCounter::grace_period());
+
+        l.grace_period(std::chrono::milliseconds(10));
+        l.shrink();
+
+        Assert(l.grace_period(), is_equal_to(more::TimeStampCounter::ticks(std::chrono::milliseconds(10))));
+    }
+
+    Test(adaptive_open_section)
+    {
+        struct tag;
+        typedef more::read_latency<tag> latency;
+
+        more::shared_list<int> l {1,2,3};
+
+        l.adapt_grace_period<tag>();
+
+        for(int i = 0; i < 100; i++)
+        {
+            latency::guard g;
+            for(auto &e : l)
+                (void)e;
+        }
+
+        l.shrink();
+        Assert(l.grace_period() < more::TimeStampCounter::ticks(std::chrono::milliseconds(20)));
+
+        /* a reader stalled inside its section is seen before it ends */
+
+        std::atomic<int> state(0);
+
+        std::thread t([&] {
+            latency::guard g;
+            state.store(1);
+            while (state.load() != 2)
+                std::this_thread::yield();
+        });
+
+        while (state.load() != 1)
+            std::this_thread::yield();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        Assert(latency::open_section() >= more::TimeStampCounter::ticks(std::chrono::milliseconds(20)));
+
+        l.shrink();
+        Assert(l.grace_period() >= more::TimeStampCounter::ticks(std::chrono::milliseconds(20)));
+
+        state.store(2);
+        t.join();
+
+        Assert(latency::open_section(), is_equal_to(0));
+
+        /* older samples can be halved or dropped */
+
+        Assert(latency::samples(), is_equal_to(100));
+        latency::decay();
+        Assert(latency::samples() <= 50);
+        Assert(latency::samples() > 0);
+
+        latency::reset();
+        Assert(latency::samples(), is_equal_to(0));
+
+        l.shrink();
+        Assert(l.grace_period(), is_equal_to(more::TimeStampCounter::grace_period()));
+    }
+
+    Test(adaptive_between_scans)
+    {
+        struct tag;
+        typedef more::read_latency<tag> latency;
+
+        more::shared_list<int> l {1,2,3,4,5,6,7,8};
+
+        l.adapt_grace_period<tag>();
+
+        for(int i = 0; i < 100; i++)
+        {
+            latency::guard g;
+            for(auto &e : l)
+                (void)e;
+        }
+
+        l.shrink();
+        Assert(l.grace_period() < more::TimeStampCounter::ticks(std::chrono::milliseconds(20)));
+
+        /* a section opened after the last scan, outlasting the cached
+         * grace period */
+
+        std::atomic<int> state(0);
+
+        std::thread t([&] {
+            latency::guard g;
+            state.store(1);
+            while (state.load() != 2)
+                std::this_thread::yield();
+        });
+
+        while (state.load() != 1)
+            std::this_thread::yield();
+
+        l.pop_front();
+        l.pop_front();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+
+        /* neither the erase nor the insert take the nodes it may hold */
+
+        l.pop_front();
+        auto erased = l.garbage_size();
+
+        l.push_back(9);
+        auto inserted = l.garbage_size();
+
+        state.store(2);
+        t.join();
+
+        Assert(erased, is_equal_to(3));
+        Assert(inserted, is_equal_to(3));
+
+        l.pop_front();
+        Assert(l.garbage_size(), is_equal_to(3));
+
+        l.push_back(10);
+        Assert(l.garbage_size(), is_equal_to(2));
+    }
+
+    Test(watermarks)
+    {
+        more::shared_list<int, more::TimePoint> l(std::chrono::seconds(10));
+
+        int high = 0, low = 0;
+
+        more::watermarks w;
+        w.high_nodes = 8;
+        w.low_nodes  = 2;
+        w.on_high = [&](size_t, size_t) { high++; };
+        w.on_low  = [&](size_t, size_t) { low++; };
+
+        l.set_watermarks(w);
+
+        for(int i = 0; i < 20; i++)
+            l.push_back(i);
+
+        for(int i = 0; i < 10; i++)
+            l.pop_front();
+
+        /* nothing is expired yet: the pressure is signalled once */
+
+        Assert(high, is_equal_to(1));
+        Assert(low,  is_equal_to(0));
+        Assert(l.garbage_size(), is_equal_to(10));
+        Assert(l.garbage_bytes() >= 10 * sizeof(int));
+
+        l.grace_period(std::chrono::milliseconds(1));
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+        l.pop_front();
+
+        Assert(high, is_equal_to(1));
+        Assert(low,  is_equal_to(1));
+        Assert(l.garbage_size() <= 2);
+    }
+
+    Test(watermarks_wait)
+    {
+        more::shared_list<int, more::TimePoint> l(std::chrono::milliseconds(20));
+
+        more::watermarks w;
+        w.high_nodes = 4;
+        w.wait = std::chrono::seconds(1);
+
+        l.set_watermarks(w);
+
+        for(int i = 0; i < 10; i++)
+            l.push_back(i);
+
+        for(int i = 0; i < 5; i++)
+            l.pop_front();
+
+        /* the writer waited for the oldest grace period */
+
+        Assert(l.garbage_size() <= 4);
+    }
+
+    Test(batch_retire)
+    {
+        more::shared_list<int, more::TimePoint> l(std::chrono::milliseconds(1));
+
+        for(int i = 0; i < 100; i++)
+            l.push_back(i);
+
+        auto it = l.erase(std::next(l.begin(), 10), std::next(l.begin(), 90));
+
+        Assert(*it, is_equal_to(90));
+        Assert(l.size(), is_equal_to(20));
+        Assert(l.reverse_size(), is_equal_to(20));
+        Assert(l.garbage_size(), is_equal_to(80));
+
+        l.clear();
+
+        Assert(l.garbage_size(), is_equal_to(100));
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+        /* nodes of a batch share the stamp of the first one */
+
+        Assert(l.shrink(), is_equal_to(100));
+        Assert(l.garbage_size(), is_equal_to(0));
+
+        l = {1,2,3};
+        l.erase(l.begin(), l.end());
+
+        Assert(l.empty());
+        Assert(l.reverse_size(), is_equal_to(0));
+    }
+
+    Test(disposer)
+    {
+        static std::atomic<int> inline_dtor, deferred_dtor;
+
+        struct tracked
+        {
+            std::thread::id owner;
+
+            tracked()
+            : owner(std::this_thread::get_id())
+            {}
+
+            ~tracked()
+            {
+                if (owner == std::this_thread::get_id())
+                    inline_dtor++;
+                else
+                    deferred_dtor++;
+            }
+        };
+
+        inline_dtor.store(0);
+        deferred_dtor.store(0);
+
+        more::disposer d(16);
+        {
+            more::shared_list<tracked, more::TimePoint> l(std::chrono::milliseconds(1));
+            l.attach(d);
+
+            for(int i = 0; i < 100; i++)
+                l.emplace_back();
+
+            inline_dtor.store(0);
+
+            for(int i = 0; i < 100; i++)
+                l.pop_front();
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            l.shrink();
+
+            l.detach();
+
+            /* the values have been destroyed off the writer thread */
+
+            Assert(deferred_dtor.load(), is_equal_to(100));
+            Assert(inline_dtor.load(), is_equal_to(0));
+        }
+
+        Assert(d.posted() > 0);
+        Assert(d.disposed(), is_equal_to(100));
+        Assert(d.pending(), is_equal_to(0));
+    }
+
+    Test(disposer_recycle)
+    {
+        static std::atomic<int> inline_dtor;
+
+        struct tracked
+        {
+            std::thread::id owner;
+
+            tracked()
+            : owner(std::this_thread::get_id())
+            {}
+
+            ~tracked()
+            {
+                if (owner == std::this_thread::get_id())
+                    inline_dtor++;
+            }
+        };
+
+        more::disposer d(16);
+        {
+            more::shared_list<tracked, more::TimePoint> l(std::chrono::milliseconds(1));
+            l.attach(d);
+
+            for(int i = 0; i < 100; i++)
+                l.emplace_back();
+
+            inline_dtor.store(0);
+
+            /* steady erase and insert: expired nodes are not taken back
+             * by the writer, their values go to the disposer */
+
+            for(int i = 0; i < 1000; i++)
+            {
+                l.pop_front();
+                l.emplace_back();
+                if (i % 100 == 0)
+                    std::this_thread::sleep_for(std::chrono::milliseconds(2));
+            }
+
+            std::this_thread::sleep_for(std::chrono::milliseconds(5));
+            l.shrink();
+            l.detach();
+
+            Assert(inline_dtor.load(), is_equal_to(0));
+        }
+
+        Assert(d.disposed() >= 900);
+    }
+
+    Test(dispose)
+    {
+        allocated.store(0);
+
+        more::shared_list<int, more::TimeStampCounter, counting_allocator<int>> l {1,2,3,4,5,6,7,8,9,10};
+
+        for(int i = 0; i < 5; i++)
+            l.pop_front();
+
+        /* no readers: retired nodes do not wait for the grace period */
+
+        l.dispose();
+
+        Assert(l.empty());
+        Assert(allocated.load(), is_equal_to(0));
+
+        l.push_back(42);
+        Assert(l.front(), is_equal_to(42));
+    }
+
+
+    Test(defer)
+    {
+        more::shared_list<int, more::TimePoint> l(std::chrono::seconds(10));
+
+        bool done = false;
+
+        l.push_back(1);
+        l.pop_front();
+        l.defer([&] { done = true; });
+
+        l.shrink();
+        Assert(!done);
+
+        l.grace_period(std::chrono::milliseconds(1));
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+        l.shrink();
+        Assert(done);
+
+        /* pending callbacks are run by dispose() */
+
+        done = false;
+        l.grace_period(std::chrono::seconds(10));
+        l.defer([&] { done = true; });
+        l.dispose();
+        Assert(done);
+    }
+
+    Test(slab_allocator)
+    {
+        typedef more::shared_list<int, more::TimePoint, more::slab_allocator<int, 64, 16>> list_type;
+
+        list_type l(std::chrono::milliseconds(1));
+
+        for(int i = 0; i < 100; i++)
+            l.push_back(i);
+
+        /* nodes are cache-line aligned and contiguous within a chunk */
+
+        std::vector<uintptr_t> addr;
+        for(auto &x : l)
+            addr.push_back(reinterpret_cast<uintptr_t>(&x));
+
+        for(auto a : addr)
+            Assert(a % 64, is_equal_to(addr[0] % 64));
+
+        for(size_t i = 1; i < 16; i++)
+            Assert(addr[i] - addr[i-1], is_equal_to(64));
+
+        /* destroyed nodes are reused */
+
+        for(int i = 0; i < 50; i++)
+            l.pop_front();
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        l.shrink();
+
+        for(int i = 0; i < 50; i++)
+            l.push_back(i);
+
+        for(auto &x : l)
+            Assert(std::find(addr.begin(), addr.end(), reinterpret_cast<uintptr_t>(&x)) != addr.end());
+
+        list_type c(l);
+        Assert(c.size(), is_equal_to(100));
+
+        l.dispose();
+        Assert(l.empty());
+
+        l.push_back(42);
+        Assert(l.front(), is_equal_to(42));
+        Assert(c.back(), is_equal_to(49));
+    }
+
+    Test(huge_page_allocator)
+    {
+        more::shared_list<int, more::TimePoint, more::huge_page_allocator<int, 64>> l(std::chrono::milliseconds(1));
+
+        for(int i = 0; i < 10000; i++)
+            l.push_back(i);
+
+        /* the first nodes come from a single chunk, a huge page wide */
+
+        auto page = reinterpret_cast<uintptr_t>(&l.front()) & ~(more::defaults::huge_page - 1);
+        for(auto &x : l)
+            Assert(reinterpret_cast<uintptr_t>(&x) & ~(more::defaults::huge_page - 1), is_equal_to(page));
+
+        l.clear();
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        l.shrink();
+
+        l.push_back(42);
+        Assert(l.front(), is_equal_to(42));
+
+        l.dispose();
+        Assert(l.empty());
+    }
+
+    Test(concurrent_push_back)
+    {
+        more::shared_list<int> l;
+
+        l.concurrent_push_back(1);
+        l.concurrent_emplace_back(2);
+        l.push_back(3);
+        l.concurrent_push_back(4);
+
+        Assert(l.front(), is_equal_to(1));
+        Assert(l.back(), is_equal_to(4));
+        Assert(l.reverse_size(), is_equal_to(4));
+
+        /* erasing at the tail, then appending again */
+
+        l.erase(std::next(l.begin(), 2));
+        l.erase(std::next(l.begin(), 2));
+        l.concurrent_push_back(5);
+
+        std::vector<int> v(l.begin(), l.end());
+        Assert(v, is_equal_to(std::vector<int>{1,2,5}));
+        Assert(l.reverse_size(), is_equal_to(3));
+    }
+
+    Test(numa_node)
+    {
+        more::shared_list<int, more::TimePoint, more::slab_allocator<int, 64, 1024>> l;
+
+        Assert(l.numa_node(), is_equal_to(-1));
+
+        /* a hint: it holds even where there is no NUMA support */
+
+        l.numa_node(0);
+        Assert(l.numa_node(), is_equal_to(0));
+
+        for(int i = 0; i < 10000; i++)
+            l.push_back(i);
+
+        Assert(l.size(), is_equal_to(10000));
+        Assert(l.back(), is_equal_to(9999));
+
+        /* the chunks carved since prefer the node, the storage of a list
+         * left alone follows the default policy */
+
+        int mode, node;
+        if (numa_policy(&*std::next(l.begin(), 5000), mode, node))
+        {
+            Assert(mode, is_equal_to(static_cast<int>(MPOL_PREFERRED)));
+            Assert(node, is_equal_to(0));
+
+            decltype(l) o;
+            for(int i = 0; i < 10000; i++)
+                o.push_back(i);
+
+            Assert(numa_policy(&*std::next(o.begin(), 5000), mode, node));
+            Assert(mode, is_equal_to(static_cast<int>(MPOL_DEFAULT)));
+        }
+
+        decltype(l) m(std::move(l));
+        Assert(m.numa_node(), is_equal_to(-1));
+        Assert(m.size(), is_equal_to(10000));
+    }
+
+    Test(record_alignment)
+    {
+        struct tag;
+
+        Assert(sizeof(more::detail::section_record), is_equal_to(64));
+        Assert(sizeof(more::detail::reader_record), is_equal_to(64));
+        Assert(sizeof(more::detail::hazard_record), is_equal_to(64));
+        Assert(alignof(more::detail::hazard_record), is_equal_to(64));
+        Assert(alignof(more::detail::latency_record), is_equal_to(64));
+        Assert(sizeof(more::detail::latency_record) % 64, is_equal_to(0));
+        Assert(offsetof(more::detail::latency_record, start) % 64, is_equal_to(0));
+
+        /* records of different threads never share a cache line */
+
+        auto a = reinterpret_cast<uintptr_t>(&more::read_section<tag>::registry::local());
+        uintptr_t b = 0;
+
+        std::thread t([&] {
+            b = reinterpret_cast<uintptr_t>(&more::read_section<tag>::registry::local());
+        });
+        t.join();
+
+        Assert(a % 64, is_equal_to(0));
+        Assert(b % 64, is_equal_to(0));
+    }
+
+    Test(track_readers)
+    {
+        struct tag;
+
+        more::shared_list<int> l(std::chrono::seconds(10));
+        l.track_readers<tag>();
+
+        for(int i = 0; i < 10; i++)
+            l.push_back(i);
+
+        /* no reader inside: a scan does not wait for the grace period */
+
+        l.pop_front();
+        Assert(l.shrink(), is_equal_to(1));
+        Assert(l.garbage_size(), is_equal_to(0));
+
+        std::atomic<int> state(0);
+
+        std::thread t([&] {
+            more::read_section<tag>::guard g;
+            state.store(1);
+            while (state.load() != 2)
+                std::this_thread::yield();
+        });
+
+        while (state.load() != 1)
+            std::this_thread::yield();
+
+        l.pop_front();
+        l.pop_front();
+        Assert(l.shrink(), is_equal_to(0));
+        Assert(l.garbage_size(), is_equal_to(2));
+
+        state.store(2);
+        t.join();
+
+        Assert(l.shrink(), is_equal_to(2));
+        Assert(l.size(), is_equal_to(7));
+    }
+
+    Test(synchronize)
+    {
+        more::shared_list<int, more::TimePoint> l(std::chrono::milliseconds(20));
+
+        auto start = std::chrono::steady_clock::now();
+        l.synchronize();
+
+        Assert(std::chrono::steady_clock::now() - start >= std::chrono::milliseconds(20));
+    }
+
+    Test(reclaimer)
+    {
+        more::reclaimer r(std::chrono::milliseconds(1));
+
+        more::shared_list<int, more::EpochBased> l {1,2,3,4,5,6,7,8,9,10};
+        l.attach(r);
+
+        Assert(l.attached());
+
+        {
+            more::EpochBased::guard g;
+            for(int i = 0; i < 10; i++)
+                l.pop_front();
+        }
+
+        for(int i = 0; i < 1000 && r.reclaimed() < 10; i++)
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+
+        Assert(r.reclaimed(), is_equal_to(10));
+        Assert(l.shrink(), is_equal_to(0));
+
+        l.detach();
+        Assert(!l.attached());
+    }
+
+    Test(move_attached)
+    {
+        more::reclaimer r(std::chrono::milliseconds(1));
+
+        more::shared_list<int, more::TimePoint> l(std::chrono::milliseconds(1));
+        l.attach(r);
+
+        for(int i = 0; i < 100; i++)
+        {
+            for(int j = 0; j < 50; j++)
+                l.push_back(j);
+            for(int j = 0; j < 50; j++)
+                l.pop_front();
+
+            /* the reclaimer may be flushing l meanwhile */
+
+            more::shared_list<int, more::TimePoint> m(std::move(l));
+            Assert(!m.attached());
+
+            l = std::move(m);
+        }
+
+        /* the attachment stays behind */
+
+        Assert(l.attached());
+        l.detach();
+    }
+
     Test(multiple_destroy)
     {
         more::shared_list<int> l1 {1,2,3,4,5,6,7,8,9,10};
@@ -762,6 +1540,306 @@ Context(single_thread)
 }
 
 
+Context(epoch_based)
+{
+    typedef more::shared_list<int, more::EpochBased> list_type;
+
+    Test(shrink)
+    {
+        list_type l {1,2,3,4,5,6,7,8,9,10};
+
+        {
+            more::EpochBased::guard g;
+
+            for(int i = 0; i < 5; i++)
+                l.pop_front();
+
+            Assert(l.shrink(), is_equal_to(0));
+        }
+
+        Assert(l.shrink(), is_equal_to(5));
+
+        /* no active readers: erasures compare against the horizon of the
+         * last scan, the next scan reclaims them all */
+
+        for(int i = 0; i < 5; i++)
+            l.pop_front();
+
+        Assert(l.shrink(), is_equal_to(5));
+        Assert(l.empty());
+    }
+
+    Test(recycle)
+    {
+        list_type l {1,2,3};
+
+        auto p = &l.front();
+
+        l.pop_front();
+
+        /* the node is taken back once the cached horizon is renewed */
+
+        size_t n = 0;
+        do {
+            l.push_back(42);
+        }
+        while (&l.back() != p && ++n < 2 * more::defaults::scan_threshold);
+
+        Assert(&l.back() == p);
+        Assert(l.back(), is_equal_to(42));
+        Assert(l.shrink(), is_equal_to(0));
+    }
+
+    Test(nested_guard)
+    {
+        list_type l {1,2,3};
+
+        more::EpochBased::guard g1;
+        {
+            more::EpochBased::guard g2;
+        }
+
+        l.pop_front();
+        Assert(l.shrink(), is_equal_to(0));
+    }
+
+    Test(reader_thread)
+    {
+        list_type l {1,2,3};
+
+        std::atomic<int> state(0);
+
+        std::thread t([&] {
+            more::EpochBased::guard g;
+            state.store(1);
+            while (state.load() != 2)
+                std::this_thread::yield();
+        });
+
+        while (state.load() != 1)
+            std::this_thread::yield();
+
+        l.pop_front();
+        Assert(l.shrink(), is_equal_to(0));
+
+        state.store(2);
+        t.join();
+
+        Assert(l.shrink(), is_equal_to(1));
+    }
+
+
+    Test(synchronize)
+    {
+        list_type l {1,2,3};
+
+        std::atomic<int> state(0);
+
+        std::thread t([&] {
+            more::EpochBased::guard g;
+            state.store(1);
+            while (state.load() != 2)
+                std::this_thread::yield();
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+            state.store(3);
+        });
+
+        while (state.load() != 1)
+            std::this_thread::yield();
+
+        bool done = false;
+
+        l.pop_front();
+        l.defer([&] { done = true; });
+        l.shrink();
+        Assert(!done);
+
+        state.store(2);
+        l.synchronize();
+        Assert(state.load(), is_equal_to(3));
+
+        t.join();
+
+        l.shrink();
+        Assert(done);
+    }
+}
+
+
+Context(quiescent)
+{
+    typedef more::shared_list<int, more::Quiescent> list_type;
+
+    Test(no_readers)
+    {
+        list_type l {1,2,3};
+
+        l.pop_front();
+        l.pop_front();
+
+        Assert(l.shrink(), is_equal_to(2));
+        Assert(l.size(), is_equal_to(1));
+    }
+
+    Test(reader_thread)
+    {
+        list_type l {1,2,3};
+
+        std::atomic<int> state(0);
+
+        std::thread t([&] {
+            more::Quiescent::registration r;
+            state.store(1);
+
+            while (state.load() != 2)
+            {
+                for(auto &e : l)
+                    (void)e;
+            }
+
+            more::Quiescent::quiescent();
+            state.store(3);
+
+            while (state.load() != 4)
+                std::this_thread::yield();
+        });
+
+        while (state.load() != 1)
+            std::this_thread::yield();
+
+        l.pop_front();
+        Assert(l.shrink(), is_equal_to(0));
+
+        state.store(2);
+        while (state.load() != 3)
+            std::this_thread::yield();
+
+        Assert(l.shrink(), is_equal_to(1));
+
+        state.store(4);
+        t.join();
+    }
+}
+
+
+Context(hazard_pointer)
+{
+    typedef more::shared_list<int, more::HazardPointer> list_type;
+
+    Test(no_readers)
+    {
+        list_type l {1,2,3,4,5,6,7,8,9,10};
+
+        for(int i = 0; i < 10; i++)
+            l.pop_front();
+
+        Assert(l.shrink(), is_equal_to(10));
+        Assert(l.shrink(), is_equal_to(0));
+    }
+
+    Test(protected_iterator)
+    {
+        list_type l {1,2,3,4,5,6,7,8,9,10};
+
+        {
+            auto it = std::next(l.cbegin(), 4);
+
+            for(int i = 0; i < 10; i++)
+                l.pop_front();
+
+            /* 5 and the nodes retired after it are still reachable */
+
+            Assert(l.shrink(), is_equal_to(4));
+            Assert(*it, is_equal_to(5));
+            Assert(*++it, is_equal_to(6));
+        }
+
+        Assert(l.shrink(), is_equal_to(6));
+    }
+
+    Test(iterate_erased)
+    {
+        list_type l {1,2,3,4,5};
+
+        auto it = std::next(l.begin(), 2);
+        auto cp = it;
+
+        l.erase(std::next(l.begin(), 2));
+        l.erase(std::next(l.begin(), 2));
+        l.shrink();
+
+        Assert(*it++, is_equal_to(3));
+        Assert(*it++, is_equal_to(4));
+        Assert(*it++, is_equal_to(5));
+        Assert(it == l.end());
+        Assert(*cp, is_equal_to(3));
+
+        std::vector<int> v(l.begin(), l.end());
+        Assert(v, is_equal_to(std::vector<int>{1,2,5}));
+    }
+
+    Test(clear_iterating)
+    {
+        more::shared_list<std::string, more::HazardPointer> l;
+
+        for(int i = 0; i < 5; i++)
+            l.push_back(std::string(100, 'a' + i));
+
+        auto it = l.cbegin();
+
+        l.clear();
+        l.shrink();
+
+        /* the successors of a protected node are retired after it */
+
+        Assert((*++it)[0], is_equal_to('b'));
+        Assert((*++it)[0], is_equal_to('c'));
+    }
+
+    Test(erase_range_iterating)
+    {
+        more::shared_list<std::string, more::HazardPointer> l;
+
+        for(int i = 0; i < 5; i++)
+            l.push_back(std::string(100, 'a' + i));
+
+        auto it = std::next(l.cbegin());
+
+        l.erase(std::next(l.cbegin()), std::next(l.cbegin(), 4));
+        l.shrink();
+
+        Assert((*++it)[0], is_equal_to('c'));
+        Assert((*++it)[0], is_equal_to('d'));
+        Assert((*++it)[0], is_equal_to('e'));
+    }
+
+
+    Test(defer)
+    {
+        list_type l {1,2,3};
+
+        bool done = false;
+
+        {
+            auto it = l.cbegin();
+
+            l.pop_front();
+            l.defer([&] { done = true; });
+
+            /* the node erased before is still protected */
+
+            l.shrink();
+            Assert(!done);
+            Assert(*it, is_equal_to(1));
+        }
+
+        l.synchronize();
+        l.shrink();
+        Assert(done);
+    }
+}
+
+
 int
 main(int argc, char * argv[])
 {
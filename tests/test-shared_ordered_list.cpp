@@ -0,0 +1,222 @@
+#include <yats.hpp>
+
+#include <shared_ordered_list.hpp>
+
+#include <vector>
+#include <thread>
+
+using namespace yats;
+
+
+Context(single_thread)
+{
+    typedef more::shared_ordered_list<int, more::TimePoint> list_type;
+
+    Test(insert)
+    {
+        list_type l;
+
+        Assert(l.empty());
+
+        Assert(l.insert(3));
+        Assert(l.insert(1));
+        Assert(l.insert(2));
+        Assert(!l.insert(2));
+
+        std::vector<int> v(l.begin(), l.end());
+        Assert(v, is_equal_to(std::vector<int>{1,2,3}));
+        Assert(l.size(), is_equal_to(3));
+    }
+
+    Test(erase)
+    {
+        list_type l;
+
+        for(int i = 0; i < 10; i++)
+            l.insert(i);
+
+        Assert(l.erase(0));
+        Assert(l.erase(5));
+        Assert(l.erase(9));
+        Assert(!l.erase(5));
+        Assert(!l.erase(42));
+
+        std::vector<int> v(l.begin(), l.end());
+        Assert(v, is_equal_to(std::vector<int>{1,2,3,4,6,7,8}));
+
+        Assert(l.contains(4));
+        Assert(!l.contains(5));
+        Assert(*l.find(8), is_equal_to(8));
+        Assert(l.find(9) == l.end());
+
+        Assert(l.garbage_size(), is_equal_to(3));
+    }
+
+    Test(shrink)
+    {
+        list_type l(std::chrono::milliseconds(1));
+
+        for(int i = 0; i < 10; i++)
+            l.insert(i);
+        for(int i = 0; i < 10; i++)
+            l.erase(i);
+
+        Assert(l.empty());
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+        l.shrink();
+        Assert(l.garbage_size(), is_equal_to(0));
+    }
+
+    Test(compare)
+    {
+        more::shared_ordered_list<int, more::TimePoint, std::greater<int>> l;
+
+        for(int i = 0; i < 5; i++)
+            l.insert(i);
+
+        std::vector<int> v(l.begin(), l.end());
+        Assert(v, is_equal_to(std::vector<int>{4,3,2,1,0}));
+    }
+}
+
+
+Context(multiple_thread)
+{
+    Test(writers)
+    {
+        const int writers = 4;
+        const int keys = 64;
+        const int rounds = 20000;
+
+        more::shared_ordered_list<int> l;
+        std::atomic<bool> stop(false);
+
+        /* readers always see a sorted list */
+
+        std::thread r([&] {
+            while (!stop.load())
+            {
+                int last = -1;
+                for(auto x : l)
+                {
+                    if (x <= last)
+                        throw std::runtime_error("unsorted");
+                    last = x;
+                }
+            }
+        });
+
+        /* every writer owns the keys equal to its id modulo writers, and
+         * leaves the even ones in */
+
+        std::vector<std::thread> ws;
+        for(int id = 0; id < writers; id++)
+        {
+            ws.emplace_back([&, id] {
+                for(int i = 0; i < rounds; i++)
+                {
+                    int k = (i % (keys / writers)) * writers + id;
+                    if (!l.insert(k) || !l.erase(k))
+                        throw std::runtime_error("lost key");
+                }
+                for(int k = id; k < keys; k += writers)
+                    if (k % 2 == 0)
+                        l.insert(k);
+            });
+        }
+
+        for(auto &w : ws)
+            w.join();
+
+        stop.store(true);
+        r.join();
+
+        std::vector<int> v(l.begin(), l.end()), e;
+        for(int k = 0; k < keys; k += 2)
+            e.push_back(k);
+
+        Assert(v, is_equal_to(e));
+    }
+
+    Test(overlapping)
+    {
+        const int writers = 4;
+        const int keys = 16;
+        const int rounds = 20000;
+
+        more::shared_ordered_list<int> l;
+        std::vector<std::atomic<int>> net(keys);
+        std::atomic<bool> stop(false);
+
+        for(auto &n : net)
+            n.store(0);
+
+        /* a strictly increasing walk also means no key is there twice */
+
+        std::thread r([&] {
+            while (!stop.load())
+            {
+                int last = -1;
+                for(auto x : l)
+                {
+                    if (x <= last)
+                        throw std::runtime_error("unsorted or duplicate");
+                    last = x;
+                }
+            }
+        });
+
+        /* all the writers race on the same keys: only the successful
+         * inserts and erases are counted */
+
+        std::vector<std::thread> ws;
+        for(int id = 0; id < writers; id++)
+        {
+            ws.emplace_back([&, id] {
+                unsigned int x = id + 1;
+                for(int i = 0; i < rounds; i++)
+                {
+                    x = x * 1103515245 + 12345;
+                    int k = (x >> 16) % keys;
+                    if ((x >> 8) & 1)
+                    {
+                        if (l.insert(k))
+                            net[k]++;
+                    }
+                    else if (l.erase(k))
+                        net[k]--;
+                }
+            });
+        }
+
+        for(auto &w : ws)
+            w.join();
+
+        stop.store(true);
+        r.join();
+
+        std::vector<int> v(l.begin(), l.end()), e;
+        for(int k = 0; k < keys; k++)
+        {
+            Assert(net[k].load() == 0 || net[k].load() == 1);
+            Assert(l.contains(k), is_equal_to(net[k].load() == 1));
+            if (net[k].load())
+            {
+                Assert(*l.find(k), is_equal_to(k));
+                e.push_back(k);
+            }
+        }
+
+        Assert(v, is_equal_to(e));
+        Assert(l.size(), is_equal_to(e.size()));
+    }
+}
+
+
+int
+main(int argc, char * argv[])
+{
+    return yats::run(argc, argv);
+}
@@ -95,6 +95,6 @@ Context(mt_tests)
 int
 main(int argc, char *argv[])
 {
-    return yats::run();
+    return yats::run(argc, argv);
 }
 
@@ -3,6 +3,34 @@
 
 using namespace yats;
 
+static bool slow_late;
+
+/* a value whose destruction waits for a flag, if given one */
+
+struct slow
+{
+    slow()
+    : go(nullptr)
+    {}
+
+    ~slow()
+    {
+        auto t0 = std::chrono::steady_clock::now();
+        while (go && !go->load())
+        {
+            if (std::chrono::steady_clock::now() - t0 > std::chrono::seconds(2))
+            {
+                slow_late = true;
+                break;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    std::atomic<bool> *go;
+};
+
+
 Context(SharedMap)
 {
     Test(default_ctor)
@@ -648,6 +676,270 @@ Context(SharedMap)
         Assert(m.load_factor(), is_equal_to(1.0));
     }
 
+
+    Test(quiescent)
+    {
+        more::shared_unordered_map<int, int, more::Quiescent> m(3);
+
+        more::Quiescent::registration r;
+
+        m.insert(std::make_pair(1, 10));
+        m.insert(std::make_pair(2, 20));
+
+        Assert(m.erase(1), is_equal_to(1));
+
+        more::Quiescent::quiescent();
+        m.shrink();
+
+        Assert(m.size(), is_equal_to(1));
+        Assert(m.at(2), is_equal_to(20));
+    }
+
+
+    Test(hazard_pointer)
+    {
+        more::shared_unordered_map<int, int, more::HazardPointer> m(3);
+
+        m.insert(std::make_pair(1, 10));
+        m.insert(std::make_pair(2, 20));
+        m.insert(std::make_pair(3, 30));
+
+        auto it = m.find(2);
+
+        Assert(m.erase(2), is_equal_to(1));
+        m.shrink();
+
+        Assert(it->second, is_equal_to(20));
+        Assert(m.size(), is_equal_to(2));
+        Assert(std::distance(m.begin(), m.end()), is_equal_to(2));
+    }
+
+
+    Test(hazard_pointer_clear)
+    {
+        more::shared_unordered_map<int, std::string, more::HazardPointer> m(1);
+
+        for(int i = 0; i < 5; i++)
+            m.insert(std::make_pair(i, std::string(100, 'a' + i)));
+
+        auto it = m.begin();
+
+        m.clear();
+        m.shrink();
+
+        /* the chain stays walkable from the protected node */
+
+        std::string s;
+        for(; it != m.end(); ++it)
+            s += it->second[0];
+
+        Assert(s.size(), is_equal_to(5));
+    }
+
+
+    Test(shared_domain)
+    {
+        more::shared_unordered_map<int, int, more::EpochBased> m;
+
+        for(int i = 0; i < 100; i++)
+            m[i] = i;
+
+        {
+            more::EpochBased::guard g;
+
+            for(int i = 0; i < 100; i++)
+                m.erase(i);
+
+            Assert(m.shrink(), is_equal_to(0));
+        }
+
+        /* nodes retired from any bucket are reclaimed in one pass */
+
+        Assert(m.shrink(), is_equal_to(100));
+        Assert(m.empty());
+    }
+
+
+    Test(grace_period)
+    {
+        more::shared_unordered_map<int, int, more::TimePoint> m(7, std::chrono::seconds(10));
+
+        Assert(m.grace_period() == std::chrono::seconds(10));
+
+        m[1] = 10;
+        m.erase(1);
+
+        Assert(m.shrink(), is_equal_to(0));
+
+        m.grace_period(std::chrono::milliseconds(1));
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+        Assert(m.shrink(), is_equal_to(1));
+    }
+
+
+    Test(batch_clear)
+    {
+        more::shared_unordered_map<int, int, more::TimePoint> m(7, std::chrono::milliseconds(1));
+
+        for(int i = 0; i < 100; i++)
+            m[i] = i;
+
+        m.erase(42);
+        m.clear();
+
+        Assert(m.empty());
+        Assert(m.garbage_size(), is_equal_to(100));
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+
+        Assert(m.shrink(), is_equal_to(100));
+
+        m[1] = 10;
+        Assert(m.at(1), is_equal_to(10));
+    }
+
+
+    Test(dispose)
+    {
+        more::shared_unordered_map<int, int> m;
+
+        for(int i = 0; i < 1000; i++)
+            m[i] = i;
+
+        for(int i = 0; i < 10; i++)
+            m.erase(i);
+
+        m.dispose(4);
+
+        Assert(m.empty());
+        Assert(m.begin() == m.end());
+        Assert(m.shrink(), is_equal_to(0));
+
+        m[1] = 10;
+        Assert(m.at(1), is_equal_to(10));
+
+        m.dispose();
+        Assert(m.count(1), is_equal_to(0));
+    }
+
+
+    Test(dispose_disposer)
+    {
+        more::disposer d(1024, 2);
+        std::atomic<bool> go(false);
+
+        {
+            more::shared_unordered_map<int, slow> m;
+            m.attach(d);
+
+            for(int i = 0; i < 1000; i++)
+                m[i];
+
+            for(int i = 1; i < 11; i++)
+                m.erase(i);
+
+            /* the destructor of this element waits for the caller to
+             * return: the destruction runs on the disposer threads */
+
+            m[0].go = &go;
+            m.dispose(4);
+            go.store(true);
+
+            Assert(m.empty());
+
+            d.wait();
+            Assert(d.disposed(), is_equal_to(1000));
+            Assert(!slow_late);
+
+            m[1];
+            Assert(m.size(), is_equal_to(1));
+        }
+    }
+
+    Test(slab_allocator)
+    {
+        typedef more::shared_unordered_map<int, int, more::TimePoint,
+                                           std::hash<int>, std::equal_to<int>,
+                                           more::slab_allocator<std::pair<const int, int>, 64>> map_type;
+
+        more::disposer d;
+
+        map_type m(7, std::chrono::milliseconds(1));
+        m.attach(d);
+
+        for(int i = 0; i < 1000; i++)
+            m[i] = i;
+
+        auto line = reinterpret_cast<uintptr_t>(&*m.find(0)) % 64;
+
+        for(int i = 0; i < 1000; i++)
+            Assert(reinterpret_cast<uintptr_t>(&*m.find(i)) % 64, is_equal_to(line));
+
+        for(int i = 0; i < 500; i++)
+            m.erase(i);
+
+        std::this_thread::sleep_for(std::chrono::milliseconds(5));
+        m.shrink();
+        m.detach();
+
+        for(int i = 0; i < 500; i++)
+            m[i] = -i;
+
+        Assert(m.size(), is_equal_to(1000));
+        Assert(m.at(42), is_equal_to(-42));
+
+        m.dispose(4);
+        Assert(m.empty());
+
+        m[1] = 10;
+        Assert(m.at(1), is_equal_to(10));
+    }
+
+    Test(huge_page_allocator)
+    {
+        typedef more::shared_unordered_map<int, int, more::TimeStampCounter,
+                                           std::hash<int>, std::equal_to<int>,
+                                           more::huge_page_allocator<std::pair<const int, int>>> map_type;
+
+        /* large enough for the bucket array to take a huge page */
+
+        map_type m(1 << 18);
+
+        for(int i = 0; i < 100000; i++)
+            m[i] = i;
+
+        Assert(m.size(), is_equal_to(100000));
+        Assert(m.at(4242), is_equal_to(4242));
+
+        m.dispose();
+        Assert(m.empty());
+    }
+
+    Test(defer)
+    {
+        int calls = 0;
+
+        {
+            more::shared_unordered_map<int, int, more::TimePoint> m(7, std::chrono::milliseconds(1));
+
+            m[1] = 10;
+            m.erase(1);
+            m.defer([&] { calls++; });
+
+            m.synchronize();
+            m.shrink();
+            Assert(calls, is_equal_to(1));
+
+            /* pending callbacks are run on destruction */
+
+            m.grace_period(std::chrono::milliseconds(20));
+            m.defer([&] { calls++; });
+        }
+
+        Assert(calls, is_equal_to(2));
+    }
+
 }
 
 